@@ -63,6 +63,21 @@ int PINLIST[8] = { // The positions of the reads
   A9, // X-axis D
   A8  // Y-axis D
 };
+// Sampling
+// 1: An ADC interrupt converts the eight pins round-robin in the background and sums every pass, loop() takes the
+//    average of all passes finished since the last frame. loop() never waits for a conversion unless it is faster than
+//    one pass (8 conversions, about 0.8 ms).
+// 0: Eight blocking analogRead() calls per loop() as before.
+#ifndef ISR_SAMPLER
+#define ISR_SAMPLER 1
+#endif
+// Passes summed at most while loop() is busy, keeps the 16 bit sums from overflowing (64 x 1023 fits).
+#define SAMPLER_MAX_PASSES 64
+// Frames averaged for the centre points in setup().
+#define CALIB_FRAMES 64
+// Define to a free pin (e.g. 10) to toggle it for every frame, used by the simavr harness in sim/ to count frames/s.
+//#define FRAME_MARKER_PIN 10
+
 // Deadzone to filter out unintended movements. Increase if the mouse has small movements when it should be idle or the mouse is too senstive to subtle movements.
 int DEADZONE = 3; // Recommended to have this as small as possible for V2 to allow smaller knob range of motion.
 
@@ -126,12 +141,90 @@ static const uint8_t _hidReportDescriptor[] PROGMEM = {
 // Centerpoint variable to be populated during setup routine.
 int centerPoints[8];
 
+#if ISR_SAMPLER
+// ADMUX/ADCSRB values for each entry of PINLIST, filled by samplerBegin().
+uint8_t samplerMux[8], samplerMuxHigh[8];
+// Written only by the ADC interrupt while samplerReady is false, read by loop() while it is true.
+volatile uint16_t samplerFrame[8];
+volatile uint8_t samplerFramePasses;
+volatile bool samplerReady = false;
+// Owned by the ADC interrupt.
+uint16_t samplerSums[8];
+uint8_t samplerPasses = 0;
+uint8_t samplerChannel = 0;
+
+// Select the PINLIST entry ch and start its conversion.
+static inline void samplerStart(uint8_t ch) {
+  ADMUX = samplerMux[ch];
+  ADCSRB = samplerMuxHigh[ch];
+  ADCSRA |= (1 << ADSC);
+}
+
+ISR(ADC_vect) {
+  samplerSums[samplerChannel] += ADC;
+  if(++samplerChannel == 8){
+    samplerChannel = 0;
+    samplerPasses++;
+    if(!samplerReady){
+      // hand the pass sums to loop() and start over
+      for(int i=0; i<8; i++){
+        samplerFrame[i] = samplerSums[i];
+        samplerSums[i] = 0;
+      }
+      samplerFramePasses = samplerPasses;
+      samplerPasses = 0;
+      samplerReady = true;
+    } else if(samplerPasses == SAMPLER_MAX_PASSES){
+      // loop() is far behind, drop the oldest passes
+      for(int i=0; i<8; i++) samplerSums[i] = 0;
+      samplerPasses = 0;
+    }
+  }
+  samplerStart(samplerChannel);
+}
+
+// Take over the ADC from analogRead() and start the round-robin conversions.
+void samplerBegin() {
+  for(int i=0; i<8; i++){
+    // same pin to channel mapping as analogRead() on the atmega32u4
+    uint8_t channel = analogPinToChannel(PINLIST[i] - A0);
+    samplerMux[i] = (DEFAULT << 6) | (channel & 0x07);
+    samplerMuxHigh[i] = ((channel >> 3) & 0x01) << MUX5;
+  }
+  // ADC clock stays at 16 MHz / 128 as set up by the Arduino core, 13 clocks (104 us) per conversion
+  ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADIF) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+  samplerStart(0);
+}
+
+// Function to read and store analogue voltages for each joystick axis. Waits for the next finished frame, the values
+// are the average of all passes since the previous frame. 0-1023
+void readAllFromJoystick(int *rawReads){
+  while(!samplerReady);
+  uint8_t passes = samplerFramePasses;
+  for(int i=0; i<8; i++){
+    rawReads[i] = (samplerFrame[i] + passes/2) / passes;
+  }
+  samplerReady = false;
+}
+#else
 // Function to read and store analogue voltages for each joystick axis.
 void readAllFromJoystick(int *rawReads){
   for(int i=0; i<8; i++){
     rawReads[i] = analogRead(PINLIST[i]);
   }
 }
+#endif
+
+// Average CALIB_FRAMES frames at rest into the centre points.
+void calibrateCenterPoints() {
+  long sums[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int rawReads[8];
+  for(int n=0; n<CALIB_FRAMES; n++){
+    readAllFromJoystick(rawReads);
+    for(int i=0; i<8; i++) sums[i] += rawReads[i];
+  }
+  for(int i=0; i<8; i++) centerPoints[i] = (sums[i] + CALIB_FRAMES/2) / CALIB_FRAMES;
+}
 
 void setup() {
   // HID protocol is set.
@@ -140,9 +233,14 @@ void setup() {
   // Begin Seral for debugging
   Serial.begin(250000);
   delay(100);
+#ifdef FRAME_MARKER_PIN
+  pinMode(FRAME_MARKER_PIN, OUTPUT);
+#endif
+#if ISR_SAMPLER
+  samplerBegin();
+#endif
   // Read idle/centre positions for joysticks.
-  readAllFromJoystick(centerPoints);
-  readAllFromJoystick(centerPoints);
+  calibrateCenterPoints();
 }
 
 // Function to send translation and rotation data to the 3DConnexion software using the HID protocol outlined earlier. Two sets of data are sent: translation and then rotation.
@@ -357,4 +455,7 @@ void loop() {
 // Send data to the 3DConnexion software.
 // The correct order for me was determined after trial and error
   send_command(rotX, rotZ, rotY, transX, transZ, transY);
+#ifdef FRAME_MARKER_PIN
+  digitalWrite(FRAME_MARKER_PIN, !digitalRead(FRAME_MARKER_PIN));
+#endif
 }
@@ -0,0 +1,163 @@
+// simavr harness for joy4_tt_v2.ino: runs the sketch on a simulated ATmega32U4 with scripted joystick voltages
+// and counts the frames loop() finishes (FRAME_MARKER_PIN toggles).
+//
+//   joy4_sim FIRMWARE.elf [-s SECONDS] [-i SCRIPT.csv]
+//
+// SCRIPT rows are "t_ms,AX,AY,BX,BY,CX,CY,DX,DY" in millivolts, linearly interpolated. Without a script every pin
+// rests at mid supply and starts moving on a slow sine after one second. The first marker toggle (calibration done)
+// starts the measurement. See Makefile for building the two sampler variants.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_time.h"
+#include "sim_cycle_timers.h"
+#include "avr_adc.h"
+#include "avr_ioport.h"
+
+#define VCC_MV 5000
+#define INPUT_PERIOD_US 100
+#define MAX_ROWS 4096
+
+// ADC channel of each PINLIST entry (A1 A0 A3 A2 A7 A6 A9 A8 on the Pro Micro)
+static const int PIN_CHANNEL[8] = { 6, 7, 4, 5, 10, 8, 12, 11 };
+// FRAME_MARKER_PIN 10 is PB6
+#define MARKER_PORT 'B'
+#define MARKER_BIT 6
+
+static struct { double ms; double mv[8]; } script[MAX_ROWS];
+static int scriptRows = 0;
+
+static avr_irq_t *adcIrq[8];
+static uint64_t toggles = 0;
+static avr_cycle_count_t firstToggle = 0, lastToggle = 0;
+
+static int loadScript(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    char line[512];
+    while (scriptRows < MAX_ROWS && fgets(line, sizeof(line), f)) {
+        char *p = line, *end;
+        script[scriptRows].ms = strtod(p, &end);
+        if (end == p) {
+            continue; // header or comment
+        }
+        for (int i = 0; i < 8; i++) {
+            p = end + (*end == ',');
+            script[scriptRows].mv[i] = strtod(p, &end);
+        }
+        scriptRows++;
+    }
+    fclose(f);
+    return scriptRows > 0;
+}
+
+static void inputAt(double ms, double *mv) {
+    if (!scriptRows) {
+        for (int i = 0; i < 8; i++) {
+            mv[i] = VCC_MV / 2 + (ms > 1000 ? 600 * sin((ms - 1000) / 1000.0 * (1 + 0.2 * i)) : 0);
+        }
+        return;
+    }
+    int r = 0;
+    while (r + 1 < scriptRows && script[r + 1].ms <= ms) {
+        r++;
+    }
+    int n = r + 1 < scriptRows ? r + 1 : r;
+    double f = script[n].ms > script[r].ms ? (ms - script[r].ms) / (script[n].ms - script[r].ms) : 0;
+    if (f < 0) f = 0;
+    if (f > 1) f = 1;
+    for (int i = 0; i < 8; i++) {
+        mv[i] = script[r].mv[i] + f * (script[n].mv[i] - script[r].mv[i]);
+    }
+}
+
+static avr_cycle_count_t updateInputs(avr_t *avr, avr_cycle_count_t when, void *param) {
+    (void)param;
+    double mv[8];
+    inputAt(when * 1000.0 / avr->frequency, mv);
+    for (int i = 0; i < 8; i++) {
+        avr_raise_irq(adcIrq[i], (uint32_t)(mv[i] < 0 ? 0 : mv[i]));
+    }
+    return when + avr_usec_to_cycles(avr, INPUT_PERIOD_US);
+}
+
+static void onMarker(avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    (void)value;
+    avr_t *avr = (avr_t *)param;
+    if (!toggles) {
+        firstToggle = avr->cycle;
+    }
+    lastToggle = avr->cycle;
+    toggles++;
+}
+
+int main(int argc, char **argv) {
+    const char *firmware = NULL;
+    double seconds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            if (!loadScript(argv[++i])) {
+                return 2;
+            }
+        } else if (!firmware) {
+            firmware = argv[i];
+        } else {
+            firmware = NULL;
+            break;
+        }
+    }
+    if (!firmware) {
+        fprintf(stderr, "usage: joy4_sim FIRMWARE.elf [-s SECONDS] [-i SCRIPT.csv]\n");
+        return 2;
+    }
+
+    elf_firmware_t f;
+    memset(&f, 0, sizeof(f));
+    if (elf_read_firmware(firmware, &f) != 0) {
+        fprintf(stderr, "%s: cannot read firmware\n", firmware);
+        return 1;
+    }
+    strcpy(f.mmcu, "atmega32u4");
+    f.frequency = 16000000;
+    avr_t *avr = avr_make_mcu_by_name(f.mmcu);
+    if (!avr) {
+        fprintf(stderr, "simavr has no atmega32u4 core\n");
+        return 1;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &f);
+    avr->vcc = avr->avcc = avr->aref = VCC_MV;
+
+    for (int i = 0; i < 8; i++) {
+        adcIrq[i] = avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + PIN_CHANNEL[i]);
+    }
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(MARKER_PORT), MARKER_BIT), onMarker, avr);
+    avr_cycle_timer_register(avr, 1, updateInputs, NULL);
+
+    avr_cycle_count_t end = (avr_cycle_count_t)(seconds * avr->frequency);
+    int state = cpu_Running;
+    while (avr->cycle < end && state != cpu_Done && state != cpu_Crashed) {
+        state = avr_run(avr);
+    }
+    if (state == cpu_Crashed) {
+        fprintf(stderr, "firmware crashed at cycle %llu\n", (unsigned long long)avr->cycle);
+        return 1;
+    }
+    if (toggles < 2) {
+        fprintf(stderr, "no frames seen on P%c%d, built with -DFRAME_MARKER_PIN=10?\n", MARKER_PORT, MARKER_BIT);
+        return 1;
+    }
+    double measured = (double)(lastToggle - firstToggle) / avr->frequency;
+    printf("%s: %llu frames in %.3f s simulated after calibration, %.0f frames/s, %.1f us per frame\n", firmware,
+        (unsigned long long)(toggles - 1), measured, (toggles - 1) / measured, measured * 1e6 / (toggles - 1));
+    return 0;
+}
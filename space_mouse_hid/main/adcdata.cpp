@@ -1,4 +1,5 @@
 #include "adcdata.h"
+#include "telemetry.h"
 
 
 int PINLIST_ADC1[] = { // The positions of the reads
@@ -18,7 +19,12 @@ int PINLIST_ADC2[] = { // The positions of the reads
 
 
 ADCData::ADCData(){
+    sampleTimeUs = 0;
+    for(int i = 0;i<6;i++) {
+    mixed[i] = 0;
+    }
     for(int i = 0;i<2*PIN_CNT;i++) {
+    noiseSigma[i] = 0;
     rawReads[i] = 0;
     centerPoints[i] = 0;
     centered[i] = 0;
@@ -26,30 +32,82 @@ ADCData::ADCData(){
     }
 }
 
+  // Retry a read expression up to ADC_READ_RETRIES times, leave the function with its error if it keeps failing.
+#define ADC_READ_RETRY(expr) do { \
+        esp_err_t err_ = (expr); \
+        for(int r_ = 0;err_ != ESP_OK && r_ < ADC_READ_RETRIES;r_++) { \
+          telemetry_count(TM_ADC_ERRORS); \
+          err_ = (expr); \
+        } \
+        if (err_ != ESP_OK) { \
+          telemetry_count(TM_ADC_ERRORS); \
+          return err_; \
+        } \
+      } while (0)
+
   // Function to read and store analogue voltages for each joystick axis.
-  void ADCData::readAllFromJoystick(int nSamples){
+  esp_err_t ADCData::readAllFromJoystick(int nSamples){
 
       int32_t lRaw[2*PIN_CNT] = {0, 0, 0, 0, 0, 0, 0, 0};
+      int64_t start = esp_timer_get_time();
       for(int j = 0;j<nSamples;j++) {
+#if ADC_BACKEND == ADC_BACKEND_SPI
+        // all channels in one DMA burst, already in AX..DY order
+        int v[2*PIN_CNT];
+        ADC_READ_RETRY(spiAdc.readFrame(v));
+        for(int i = 0;i<2*PIN_CNT;i++) {
+          lRaw[i] += v[i];
+        }
+#else
         for(int i = 0;i<PIN_CNT;i++) {
           int v1, v2;
-          ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, adc1_chans[i], &v1));
-          ESP_ERROR_CHECK(adc_oneshot_read(adc2_handle, adc2_chans[i], &v2));
+          // ADC2 reads can time out while its arbiter is busy
+          ADC_READ_RETRY(adc_oneshot_read(adc1_handle, adc1_chans[i], &v1));
+          ADC_READ_RETRY(adc_oneshot_read(adc2_handle, adc2_chans[i], &v2));
           lRaw[i] += v1;
           lRaw[i + PIN_CNT] += v2;
         }
+#endif
       }
 
       for(int i = 0;i<2*PIN_CNT;i++) {
         rawReads[i] = lRaw[i]/nSamples;
       }
+      // the average represents the middle of the burst
+      sampleTimeUs = (start + esp_timer_get_time())/2;
+      return ESP_OK;
   }
 
   void ADCData::initCenterPoints() {
-    readAllFromJoystick(100);
+    // no last good frame to hold yet, a read that keeps failing here is fatal
+    ESP_ERROR_CHECK(readAllFromJoystick(100));
     for(int i = 0;i<2*PIN_CNT;i++) {
         centerPoints[i] = rawReads[i];
     }
+
+    // noise of frames averaged like in the main loop, sets the noise floor of each mode
+    float sum[2*PIN_CNT] = {0}, sumSq[2*PIN_CNT] = {0};
+    int frames = 0;
+    for(int n = 0;n<CALIB_NOISE_FRAMES;n++) {
+        if (readAllFromJoystick(FRAME_SAMPLES) != ESP_OK) {
+            continue; // a held frame would understate the noise
+        }
+        interpolateTo1024();
+        for(int i = 0;i<2*PIN_CNT;i++) {
+            sum[i] += centered[i];
+            sumSq[i] += centered[i]*centered[i];
+        }
+        frames++;
+    }
+    for(int i = 0;i<2*PIN_CNT;i++) {
+        float mean = frames ? sum[i]/frames : 0;
+        float var = frames ? sumSq[i]/frames - mean*mean : 0;
+        noiseSigma[i] = sqrtf(var > 0 ? var : 0);
+    }
+    const float sigmaX[4] = { noiseSigma[AX], noiseSigma[BX], noiseSigma[CX], noiseSigma[DX] };
+    const float sigmaY[4] = { noiseSigma[AY], noiseSigma[BY], noiseSigma[CY], noiseSigma[DY] };
+    xProj.calibrate(sigmaX);
+    yProj.calibrate(sigmaY);
   }
 
   /**
@@ -64,7 +122,7 @@ ADCData::ADCData(){
         if (d<0) {
           pv = round(d*250.0/c);
         } else {
-          pv = round(d*250.0/(8192-c));
+          pv = round(d*250.0/(ADC_FULL_SCALE-c));
         }
         centered[i] = pv;
       }
@@ -81,6 +139,8 @@ ADCData::ADCData(){
   }
 
   void ADCData::calcRotTrans() {
+    // Deadzoned inputs: DEADZONE suppresses the idle offset a knob keeps after springing back, which the
+    // calibration noise floor below never sees.
     int* centered = this->centeredDZ;
     // Doing all through arithmetic contribution by fdmakara
     // Integer has been changed to 16 bit int16_t to match what the HID protocol expects.
@@ -91,25 +151,26 @@ ADCData::ADCData(){
     //rotX = (-centered[AY] +centered[CY])/2;
     //rotY = (+centered[BY] -centered[DY])/2;
     //rotZ = (+centered[AX] +centered[BX] +centered[CX] +centered[DX])/4;
-    // My altered calculations based on debug output. Final divisor can be changed to alter sensitivity for each axis.
-    transX = -(-centered[CY] +centered[AY])/1;  
-    transY = (-centered[BY]+centered[DY])/1;
-    if((abs(centered[AX])>DEADZONE)&&(abs(centered[BX])>DEADZONE)&&(abs(centered[CX])>DEADZONE)&&(abs(centered[DX])>DEADZONE)){
-      transZ = (-centered[AX] -centered[BX] -centered[CX] -centered[DX])/1;
-      transX = 0;
-      transY = 0;
-    } else {
-      transZ = 0;
-    } 
-    rotX = (-centered[AX] +centered[CX])/1;
-    rotY = (+centered[BX] -centered[DX])/1;
-    if((abs(centered[AY])>DEADZONE)&&(abs(centered[BY])>DEADZONE)&&(abs(centered[CY])>DEADZONE)&&(abs(centered[DY])>DEADZONE)){
-      rotZ = (+centered[AY] +centered[BY] +centered[CY] +centered[DY])/2;
-      rotX = 0;
-      rotY = 0;
-    } else {
-      rotZ = 0;
-    }
+    // My altered calculations based on debug output.
+    //transX = -(-centered[CY] +centered[AY])/1;
+    //transY = (-centered[BY]+centered[DY])/1;
+    //transZ = (-centered[AX] -centered[BX] -centered[CX] -centered[DX])/1; only if all four X > DEADZONE, then TX = TY = 0
+    //rotX = (-centered[AX] +centered[CX])/1;
+    //rotY = (+centered[BX] -centered[DX])/1;
+    //rotZ = (+centered[AY] +centered[BY] +centered[CY] +centered[DY])/2; only if all four Y > DEADZONE, then RX = RY = 0
+    // The same sums as common/differential modes of the X and Y channel groups, projected continuously
+    // with the noise floor from calibration on top of the deadzone instead of the all-four-channels gate (see mixer.h).
+    // Mode amplitude m of a sum of n channels equals n*m, of a difference of two channels 2*m.
+    // Final factor can be changed to alter sensitivity for each axis.
+    float mx[3], my[3];
+    xProj.apply(centered[AX], centered[BX], centered[CX], centered[DX], mx);
+    yProj.apply(centered[AY], centered[BY], centered[CY], centered[DY], my);
+    transX = sm_sat16(lrintf(2*my[1]));
+    transY = sm_sat16(lrintf(-2*my[2]));
+    transZ = sm_sat16(lrintf(-4*mx[0]));
+    rotX = sm_sat16(lrintf(2*mx[1]));
+    rotY = sm_sat16(lrintf(2*mx[2]));
+    rotZ = sm_sat16(lrintf(4*my[0]/2));
 
   // Alter speed to suit user preference - Use 3DConnexion slider instead for V2.
     //transX = transX/100*speed;
@@ -119,15 +180,40 @@ ADCData::ADCData(){
     //rotY = rotY/100*speed;
     //rotZ = rotZ/100*speed;
   // Invert directions if needed
-    if(INVX == true){ transX = transX*-1;};
-    if(INVY == true){ transY = transY*-1;};
-    if(INVZ == true){ transZ = transZ*-1;};
-    if(INVRX == true){ rotX = rotX*-1;};
-    if(INVRY == true){ rotY = rotY*-1;};
-    if(INVRZ == true){ rotZ = rotZ*-1;};
+    if(INVX == true){ transX = sm_sat16(-transX);};
+    if(INVY == true){ transY = sm_sat16(-transY);};
+    if(INVZ == true){ transZ = sm_sat16(-transZ);};
+    if(INVRX == true){ rotX = sm_sat16(-rotX);};
+    if(INVRY == true){ rotY = sm_sat16(-rotY);};
+    if(INVRZ == true){ rotZ = sm_sat16(-rotZ);};
+
+    mixed[0] = transX;
+    mixed[1] = transY;
+    mixed[2] = transZ;
+    mixed[3] = rotX;
+    mixed[4] = rotY;
+    mixed[5] = rotZ;
+  }
+
+  void ADCData::predictLatency(int64_t targetUs) {
+    int16_t axes[6] = { transX, transY, transZ, rotX, rotY, rotZ };
+    predictor.apply(axes, sampleTimeUs, targetUs);
+    transX = axes[0];
+    transY = axes[1];
+    transZ = axes[2];
+    rotX = axes[3];
+    rotY = axes[4];
+    rotZ = axes[5];
+  }
+
+  void ADCData::writeReport(SmReport &report) const {
+    report.set(transX, transY, transZ, rotX, rotY, rotZ);
   }
 
   void ADCData::adc_init() {
+#if ADC_BACKEND == ADC_BACKEND_SPI
+      spiAdc.init();
+#else
       adc_oneshot_unit_init_cfg_t init_config1 = {
           .unit_id = ADC_UNIT_1,
           .clk_src = ADC_RTC_CLK_SRC_DEFAULT,
@@ -156,6 +242,7 @@ ADCData::ADCData(){
           ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, adc1_chans[i], &config));
           ESP_ERROR_CHECK(adc_oneshot_config_channel(adc2_handle, adc2_chans[i], &config));
       }
+#endif
   }
 
 const static char *TAG = "SM";
@@ -199,7 +286,29 @@ void ADCData::dbg_prints() {
 
 }  
 
+void ADCData::fillTrace(TraceStagesFrame &frame) const {
+    for(int i = 0;i<2*PIN_CNT;i++) {
+        frame.raw[i] = rawReads[i];
+        frame.centered[i] = centered[i];
+        frame.deadzoned[i] = centeredDZ[i];
+    }
+    for(int i = 0;i<6;i++) {
+        frame.mixed[i] = mixed[i];
+    }
+    frame.predicted[0] = transX;
+    frame.predicted[1] = transY;
+    frame.predicted[2] = transZ;
+    frame.predicted[3] = rotX;
+    frame.predicted[4] = rotY;
+    frame.predicted[5] = rotZ;
+    frame.hdr.timestampUs = (uint32_t)sampleTimeUs;
+}
+
 void ADCData::adc_done() {
+#if ADC_BACKEND == ADC_BACKEND_SPI
+    spiAdc.done();
+#else
     ESP_ERROR_CHECK(adc_oneshot_del_unit(adc1_handle));
     ESP_ERROR_CHECK(adc_oneshot_del_unit(adc2_handle));
+#endif
 }  
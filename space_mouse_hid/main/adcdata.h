@@ -9,27 +9,50 @@
 #include "esp_timer.h"
 #include <math.h>
 #include "const.h"
+#include "trace.h"
+#include "predictor.h"
+#include "mixer.h"
+#include "hid_report.h"
+#if ADC_BACKEND == ADC_BACKEND_SPI
+#include "spi_adc.h"
+#endif
 
 //(sizeof(PINLIST_ADC1)/sizeof(int))
 #define PIN_CNT 4 
 
 class ADCData {
+#if ADC_BACKEND == ADC_BACKEND_SPI
+    SpiAdc spiAdc;
+#else
     adc_oneshot_unit_handle_t adc1_handle, adc2_handle;
     adc_channel_t adc1_chans[PIN_CNT], adc2_chans[PIN_CNT];
+#endif
     int rawReads[8];
     // Centerpoint variable to be populated during setup routine.
     int centerPoints[8];
     int centered[8];
     int centeredDZ[8];
+    int16_t mixed[6]; // calcRotTrans() output before predictLatency()
+    float noiseSigma[8]; // per channel noise at rest, centered units, measured by initCenterPoints()
+    GroupProjection xProj, yProj; // AX BX CX DX and AY BY CY DY mode projections
+    Predictor predictor;
 
 public:
   int16_t transX, transY, transZ, rotX, rotY, rotZ; // Declare movement variables at 16 bit integers
+  int64_t sampleTimeUs; // esp_timer time of the middle of the last readAllFromJoystick() burst
 
   ADCData();
   
-  // Function to read and store analogue voltages for each joystick axis.
-  void readAllFromJoystick(int nSamples);
+  /**
+   * Function to read and store analogue voltages for each joystick axis. Each failed read is retried
+   * ADC_READ_RETRIES times; if it still fails the frame is abandoned and the previous values and
+   * sampleTimeUs are kept (the last good frame is held).
+  */
+  esp_err_t readAllFromJoystick(int nSamples);
 
+  /**
+   * read the rest position of all channels, then their frame noise, and build the mode projections
+  */
   void initCenterPoints();
 
   /**
@@ -41,10 +64,21 @@ public:
 
   void calcRotTrans();
 
+  /**
+   * extrapolate the rot/trans values from sampleTimeUs to targetUs, the expected USB transmit time
+  */
+  void predictLatency(int64_t targetUs);
+
+  // Write the final rot/trans values into a transmit slot.
+  void writeReport(SmReport &report) const;
+
   void adc_init();
 
   void dbg_prints();
 
+  // Copy all pipeline stages and the sample time into a trace frame, rest of the header is filled by trace_push().
+  void fillTrace(TraceStagesFrame &frame) const;
+
   void adc_done();
 
 };
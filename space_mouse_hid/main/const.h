@@ -1,9 +1,81 @@
+#pragma once
+
+#include "sdkconfig.h"
+
 #define DEBUG (0)
 
+// Joystick sensing. Internal: the ESP32-S2 ADC1/ADC2 oneshot driver on PINLIST_ADC1/PINLIST_ADC2.
+// SPI: an external MCP3208 on the FSPI bus, channel 0..7 wired to AX AY BX BY CX CY DX DY.
+#define ADC_BACKEND_INTERNAL 1
+#define ADC_BACKEND_SPI 2
+#define ADC_BACKEND ADC_BACKEND_INTERNAL
+
+#if ADC_BACKEND == ADC_BACKEND_SPI
+#define ADC_FULL_SCALE 4096
+#else
+#define ADC_FULL_SCALE 8192
+#endif
+
+// MCP3208 wiring (FSPI IOMUX pins) and clock. The chip is specified up to 1 MHz at 2.7 V, 2 MHz at 5 V.
+#define SPI_ADC_SCLK 36
+#define SPI_ADC_MOSI 35
+#define SPI_ADC_MISO 37
+#define SPI_ADC_CS 34
+#define SPI_ADC_CLOCK_HZ 1000000
+// Longest wait for the transfers of one frame (they take about 0.2 ms at 1 MHz). On a timeout the
+// frame fails like any ADC error, the late transfers are collected at the start of the next one.
+#define SPI_ADC_TIMEOUT_MS 10
+
+// Binary trace stream of every pipeline stage over a second USB interface (CDC-ACM).
+// Needs CONFIG_TINYUSB_CDC_ENABLED. Unlike DEBUG it does not format text in the sampling loop,
+// frames are queued into a ring and dropped (and counted) if the host does not keep up.
+// Decode on the host with tools/trace2csv.py. Off by default: the composite device is not handled by the
+// 3Dconnexion driver. Build with the sdkconfig.trace overlay (CONFIG_SM_TRACE) to enable it.
+#ifdef CONFIG_SM_TRACE
+#define TRACE (1)
+#else
+#define TRACE (0)
+#endif
+
+// Extrapolate the outputs to the expected USB transmit time to hide averaging and poll latency.
+// See predictor.h for the tuning constants.
+#define PREDICT (1)
+
+// Static allocation profile (CONFIG_SM_STATIC_ALLOC, set by the sdkconfig.static overlay).
+// The pipeline state lives in .bss instead of the main task stack, task stacks are trimmed,
+// the freed RAM goes to a longer trace ring, and a stack/RAM budget report is logged every
+// BUDGET_REPORT_PERIOD_MS for tools/budget_check.py.
+#ifdef CONFIG_SM_STATIC_ALLOC
+#define STATIC_ALLOC (1)
+#else
+#define STATIC_ALLOC (0)
+#endif
+#define BUDGET_REPORT_PERIOD_MS 10000
+
+// The main loop blocks LOOP_DELAY_TICKS RTOS ticks after every frame (at least one, so the idle
+// task gets to run): the loop period is the sampling time rounded up to the next tick boundary.
+#define LOOP_DELAY_TICKS 1
+
+// Sampler health (health.h). Latency SLO: a fresh frame handed to USB (txSubmit) more than
+// FRAME_DEADLINE_US after it was sampled (the middle of the averaging burst) is a deadline miss.
+// Half a HID poll interval: an older frame waits longer in the device than for the poll itself.
+// A failed ADC read is retried ADC_READ_RETRIES times, then the frame is held at the last good
+// values. The task watchdog (CONFIG_ESP_TASK_WDT_TIMEOUT_S) resets the device only if the main
+// loop itself stops.
+#define FRAME_DEADLINE_US 5000
+#define ADC_READ_RETRIES 2
+
 // Deadzone to filter out unintended movements. Increase if the mouse has small movements when it should be idle or the mouse is too senstive to subtle movements.
 // Recommended to have this as small as possible for V2 to allow smaller knob range of motion.
 #define DEADZONE 5 
 
+// ADC reads averaged into one frame in the main loop.
+#define FRAME_SAMPLES 5
+
+// Frames of FRAME_SAMPLES measured at rest during calibration to estimate the channel noise
+// for the Z decoupling projection (see mixer.h).
+#define CALIB_NOISE_FRAMES 40
+
 // Axes are matched to pin order.
 #define AX 0
 #define AY 1
@@ -0,0 +1,70 @@
+#include "esp_log.h"
+#include "esp_task_wdt.h"
+#include "const.h"
+#include "health.h"
+#include "telemetry.h"
+
+static const char *TAG = "SM_HEALTH";
+
+HealthMonitor::HealthMonitor() {
+    lastFrameUs = 0;
+    heldUs = 0;
+    holding = false;
+    watched = false;
+}
+
+void HealthMonitor::start() {
+    // the watchdog itself (timeout, idle task checks, panic) stays as the system configured it
+    esp_err_t err = esp_task_wdt_add(NULL);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "task watchdog not running (CONFIG_ESP_TASK_WDT_INIT), sampler not watched: %s",
+            esp_err_to_name(err));
+    } else {
+        watched = true;
+    }
+#ifdef CONFIG_ESP_TASK_WDT_TIMEOUT_S
+    ESP_LOGI(TAG, "watchdog %d s, frame deadline %d us", CONFIG_ESP_TASK_WDT_TIMEOUT_S, FRAME_DEADLINE_US);
+#else
+    ESP_LOGI(TAG, "frame deadline %d us", FRAME_DEADLINE_US);
+#endif
+}
+
+void HealthMonitor::frameDone(bool fresh, int64_t sampleUs, int64_t nowUs) {
+    if (fresh) {
+        // a held frame's age only tells how long it has been held, that is TM_HELD_MS
+        int64_t latency = nowUs - sampleUs;
+        if (latency > FRAME_DEADLINE_US) {
+            telemetry_count(TM_DEADLINE_MISSES);
+        }
+        telemetry_max(TM_LATENCY_MAX_US, latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency);
+    }
+    if (lastFrameUs) {
+        int64_t gap = nowUs - lastFrameUs;
+        telemetry_max(TM_FRAME_GAP_MAX_US, gap > UINT32_MAX ? UINT32_MAX : (uint32_t)gap);
+        if (holding) {
+            // the previous frame was held, the time up to this one was spent holding
+            heldUs += gap;
+            telemetry_count(TM_HELD_MS, (uint32_t)(heldUs / 1000));
+            heldUs %= 1000;
+        }
+    }
+    lastFrameUs = nowUs;
+
+    if (!fresh) {
+        telemetry_count(TM_HELD_FRAMES);
+        holding = true;
+    } else if (holding) {
+        telemetry_count(TM_ADC_RECOVERIES);
+        holding = false;
+    }
+    if (watched) {
+        esp_task_wdt_reset();
+    }
+}
+
+void HealthMonitor::idle() {
+    lastFrameUs = 0;
+    if (watched) {
+        esp_task_wdt_reset();
+    }
+}
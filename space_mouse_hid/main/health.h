@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * Sampler health. Every fresh frame handed to USB is checked against the latency SLO,
+ * FRAME_DEADLINE_US from its sample time; misses, the worst latency, the longest gap between
+ * frames, frames held after a failed ADC read and the time spent holding are counted in telemetry. The calling task is subscribed to the task watchdog (the system's
+ * configuration, CONFIG_ESP_TASK_WDT_INIT) and feeds it on every loop iteration, held frame or
+ * not: a broken ADC degrades to held values, only a loop that stops resets the device.
+ */
+class HealthMonitor {
+    int64_t lastFrameUs;
+    int64_t heldUs; // holding time not yet counted in TM_HELD_MS
+    bool holding;
+    bool watched;
+
+public:
+  HealthMonitor();
+
+  // Subscribe the calling task to the task watchdog.
+  void start();
+
+  // A frame sampled at sampleUs was handed to USB at nowUs, fresh = from a good ADC read, not the
+  // held last good one (whose sample time is that of the held frame).
+  void frameDone(bool fresh, int64_t sampleUs, int64_t nowUs);
+
+  // Nothing to sample (not mounted): feed the watchdog, the gap is not a deadline miss.
+  void idle();
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPACE_MOUSE_PRO 1
+#define SPACE_MOUSE_WIRELESS 2
+#define SPACE_MOUSE_ENTERPRISE 3
+
+#ifndef SM_DEVICE
+// two events for translation and rotation
+// #define SM_DEVICE  SPACE_MOUSE_PRO
+
+// single event for both translation and rotation
+// #define SM_DEVICE SPACE_MOUSE_WIRELESS
+
+// single event for both translation and rotation
+#define SM_DEVICE SPACE_MOUSE_ENTERPRISE
+#endif
+
+#if SM_DEVICE == SPACE_MOUSE_PRO  || SM_DEVICE == SPACE_MOUSE_WIRELESS
+#define DEVICE_TYPE 66
+#else
+#define DEVICE_TYPE 12
+#endif
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "report structs are written in place and need a little endian target"
+#endif
+
+// Clamp to the int16 range of the descriptor's logical min/max instead of wrapping.
+static inline int16_t sm_sat16(int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+typedef struct __attribute__((packed)) {
+    int16_t x, y, z;
+} SmAxes3;
+
+typedef struct __attribute__((packed)) {
+    int16_t x, y, z, rx, ry, rz;
+} SmAxes6;
+
+/**
+ * Input report payloads (without the report ID byte, TinyUSB prepends it) for one frame.
+ * The layout matches TUD_HID_REPORT_DESC_SPACE_MOUSE of the same DEVICE_TYPE.
+ */
+template<int DeviceType> struct SmReportLayout;
+
+// DEVICE_TYPE 66: report 1 = X Y Z, report 2 = RX RY RZ
+template<> struct __attribute__((packed)) SmReportLayout<66> {
+    static const int REPORT_COUNT = 2;
+    SmAxes3 trans;
+    SmAxes3 rot;
+
+    void set(int32_t x, int32_t y, int32_t z, int32_t rx, int32_t ry, int32_t rz) {
+        trans.x = sm_sat16(x);
+        trans.y = sm_sat16(y);
+        trans.z = sm_sat16(z);
+        rot.x = sm_sat16(rx);
+        rot.y = sm_sat16(ry);
+        rot.z = sm_sat16(rz);
+    }
+
+    // n-th report of the frame: ID, payload and its length
+    const uint8_t *report(int n, uint8_t &id, uint16_t &len) const {
+        id = n == 0 ? 1 : 2;
+        len = sizeof(SmAxes3);
+        return n == 0 ? (const uint8_t *)&trans : (const uint8_t *)&rot;
+    }
+};
+
+// DEVICE_TYPE 12: report 1 = X Y Z RX RY RZ
+template<> struct __attribute__((packed)) SmReportLayout<12> {
+    static const int REPORT_COUNT = 1;
+    SmAxes6 axes;
+
+    void set(int32_t x, int32_t y, int32_t z, int32_t rx, int32_t ry, int32_t rz) {
+        axes.x = sm_sat16(x);
+        axes.y = sm_sat16(y);
+        axes.z = sm_sat16(z);
+        axes.rx = sm_sat16(rx);
+        axes.ry = sm_sat16(ry);
+        axes.rz = sm_sat16(rz);
+    }
+
+    const uint8_t *report(int n, uint8_t &id, uint16_t &len) const {
+        (void)n;
+        id = 1;
+        len = sizeof(SmAxes6);
+        return (const uint8_t *)&axes;
+    }
+};
+
+static_assert(sizeof(SmReportLayout<66>) == 12, "split report layout must be packed");
+static_assert(sizeof(SmReportLayout<12>) == 12, "combined report layout must be packed");
+
+typedef SmReportLayout<DEVICE_TYPE> SmReport;
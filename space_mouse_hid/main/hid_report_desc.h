@@ -0,0 +1,84 @@
+#pragma once
+
+// HID report descriptors of the two report layouts (see hid_report.h), written with the TinyUSB
+// HID item macros, which the includer provides: the firmware through tinyusb.h, the host tools
+// (space_mouse_host/sm_descriptors.cpp) through a stand-in with the same definitions, so both
+// use the very same bytes.
+
+// DEVICE_TYPE 66 (SpaceMouse Pro / Wireless): report 1 = X Y Z, report 2 = RX RY RZ, report 3 = 32 buttons
+#define TUD_HID_REPORT_DESC_SPACE_MOUSE_SPLIT \
+  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     )                 ,\
+  HID_USAGE      ( HID_USAGE_DESKTOP_MULTI_AXIS_CONTROLLER  )   ,\
+  HID_COLLECTION ( HID_COLLECTION_APPLICATION )                 ,\
+  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
+  HID_REPORT_ID(HID_ITF_PROTOCOL_KEYBOARD)                       \
+  HID_LOGICAL_MIN_N  ( -32768, 2                              ) ,\
+  HID_LOGICAL_MAX_N  ( 32767, 2                               ) ,\
+  HID_PHYSICAL_MIN_N  ( -32768, 2                             ) ,\
+  HID_PHYSICAL_MAX_N  ( 32767, 2                              ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_X                    ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_Y                    ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_Z                    ) ,\
+  HID_REPORT_SIZE    ( 16                                     ) ,\
+  HID_REPORT_COUNT   ( 3                                      ) ,\
+  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+  HID_COLLECTION_END                                            ,\
+  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
+  HID_REPORT_ID(HID_ITF_PROTOCOL_MOUSE)                          \
+  HID_LOGICAL_MIN_N  ( -32768, 2                              ) ,\
+  HID_LOGICAL_MAX_N  ( 32767, 2                               ) ,\
+  HID_PHYSICAL_MIN_N  ( -32768, 2                             ) ,\
+  HID_PHYSICAL_MAX_N  ( 32767, 2                              ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_RX                   ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_RY                   ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_RZ                   ) ,\
+  HID_REPORT_SIZE    ( 16                                     ) ,\
+  HID_REPORT_COUNT   ( 3                                      ) ,\
+  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+  HID_COLLECTION_END                                            ,\
+  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
+  HID_REPORT_ID(3)                                               \
+  HID_LOGICAL_MIN  ( 0                                        ) ,\
+  HID_LOGICAL_MAX  ( 1                                        ) ,\
+  HID_REPORT_SIZE    ( 1                                      ) ,\
+  HID_REPORT_COUNT   ( 32                                     ) ,\
+  HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                  ) ,\
+  HID_USAGE_MIN      (1                                       ) ,\
+  HID_USAGE_MAX      (32                                      ) ,\
+  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+  HID_COLLECTION_END                                            ,\
+  HID_COLLECTION_END
+
+// DEVICE_TYPE 12 (SpaceMouse Enterprise): report 1 = X Y Z RX RY RZ, report 3 = 32 buttons
+#define TUD_HID_REPORT_DESC_SPACE_MOUSE_COMBINED \
+  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     )                 ,\
+  HID_USAGE      ( HID_USAGE_DESKTOP_MULTI_AXIS_CONTROLLER  )   ,\
+  HID_COLLECTION ( HID_COLLECTION_APPLICATION )                 ,\
+  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
+  HID_REPORT_ID(HID_ITF_PROTOCOL_KEYBOARD)                       \
+  HID_LOGICAL_MIN_N  ( -32768, 2                              ) ,\
+  HID_LOGICAL_MAX_N  ( 32767, 2                               ) ,\
+  HID_PHYSICAL_MIN_N  ( -32768, 2                             ) ,\
+  HID_PHYSICAL_MAX_N  ( 32767, 2                              ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_X                    ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_Y                    ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_Z                    ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_RX                   ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_RY                   ) ,\
+  HID_USAGE          ( HID_USAGE_DESKTOP_RZ                   ) ,\
+  HID_REPORT_SIZE    ( 16                                     ) ,\
+  HID_REPORT_COUNT   ( 6                                      ) ,\
+  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+  HID_COLLECTION_END                                            ,\
+  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
+  HID_REPORT_ID(3)                                               \
+  HID_LOGICAL_MIN  ( 0                                        ) ,\
+  HID_LOGICAL_MAX  ( 1                                        ) ,\
+  HID_REPORT_SIZE    ( 1                                      ) ,\
+  HID_REPORT_COUNT   ( 32                                     ) ,\
+  HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                  ) ,\
+  HID_USAGE_MIN      (1                                       ) ,\
+  HID_USAGE_MAX      (32                                      ) ,\
+  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
+  HID_COLLECTION_END                                            ,\
+  HID_COLLECTION_END
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// MCP3208 8 channel 12 bit SPI ADC, SPI mode 0. One conversion is a 3 byte transfer with CS low,
+// aligned so the result ends in the last byte:
+//   MOSI  0 0 0 0 0 S SGL D2 | D1 D0 x x x x x x | x x x x x x x x
+//   MISO  ? ? ? ? ? ? ?  ?   | ?  ?  ? 0 B11..B8 | B7 .. B0
+// CS has to go high between conversions, so a frame is one burst of 8 queued transfers.
+// Plain C++ so the host simulator (space_mouse_host/mcp3208_sim) runs the same frame code.
+
+#define MCP3208_CHANNELS 8
+#define MCP3208_XFER_BYTES 3
+#define MCP3208_FULL_SCALE 4096
+
+// Command bytes for a single ended conversion of channel ch.
+static inline void mcp3208_request(uint8_t ch, uint8_t *tx) {
+    tx[0] = 0x06 | ((ch >> 2) & 0x01); // start, single ended, D2
+    tx[1] = (ch & 0x03) << 6;          // D1 D0
+    tx[2] = 0;
+}
+
+// 12 bit result of a conversion. Bits before the null bit are high impedance and masked off.
+static inline uint16_t mcp3208_result(const uint8_t *rx) {
+    return ((rx[1] & 0x0F) << 8) | rx[2];
+}
+
+/**
+ * Transfer buffers for one frame of all channels. The commands never change, they are built once
+ * and every frame only moves data. Must live in DMA capable memory on the target.
+ */
+struct Mcp3208Frame {
+    uint8_t tx[MCP3208_CHANNELS][4]; // 3 bytes used, padded to keep every buffer word aligned
+    uint8_t rx[MCP3208_CHANNELS][4];
+
+    void init() {
+        memset(this, 0, sizeof(*this));
+        for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+            mcp3208_request(ch, tx[ch]);
+        }
+    }
+
+    // channel i of the frame is read into values[i]
+    void decode(int *values) const {
+        for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+            values[ch] = mcp3208_result(rx[ch]);
+        }
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <math.h>
+
+// Continuous decomposition of a group of four joystick channels (all X or all Y axes,
+// order A B C D) into one common mode and two differential modes:
+//   common  ( 1, 1, 1, 1)   X: push/pull (TZ)   Y: twist (RZ)
+//   diff AC (-1, 0, 1, 0)   X: tilt (RX)        Y: pan (TX)
+//   diff BD ( 0, 1, 0,-1)   X: tilt (RY)        Y: pan (TY)
+// The fourth pattern (1,-1,1,-1) is not a motion of the knob and is left in the residual.
+// The projection is a noise-weighted least squares fit computed once from the calibration
+// noise, so per frame it is a fixed 3x4 multiply plus a soft noise floor, no threshold branches.
+
+// Noise floor of each mode in standard deviations of its calibration noise.
+#define MIX_NOISE_SIGMAS 3.0f
+// Lower bound for channel noise, keeps the weights finite on a perfectly quiet channel.
+#define MIX_MIN_SIGMA 0.5f
+
+class GroupProjection {
+    float p[3][4];
+    float noiseFloor[3];
+
+public:
+  GroupProjection() {
+      const float sigma[4] = { 1, 1, 1, 1 };
+      calibrate(sigma);
+  }
+
+  /**
+   * build the projection from the per-channel noise (standard deviation, centered units)
+  */
+  void calibrate(const float *sigma) {
+      static const float basis[4][3] = {
+          { 1, -1,  0 },
+          { 1,  0,  1 },
+          { 1,  1,  0 },
+          { 1,  0, -1 },
+      };
+      float w[4];
+      for (int c = 0; c < 4; c++) {
+          float s = sigma[c] > MIX_MIN_SIGMA ? sigma[c] : MIX_MIN_SIGMA;
+          w[c] = 1.0f / (s * s);
+      }
+      // normal matrix N = B^T W B
+      float n[3][3];
+      for (int i = 0; i < 3; i++) {
+          for (int j = 0; j < 3; j++) {
+              n[i][j] = 0;
+              for (int c = 0; c < 4; c++) {
+                  n[i][j] += basis[c][i] * w[c] * basis[c][j];
+              }
+          }
+      }
+      // inverse by cofactors, N is symmetric positive definite
+      float inv[3][3];
+      inv[0][0] = n[1][1] * n[2][2] - n[1][2] * n[2][1];
+      inv[0][1] = n[0][2] * n[2][1] - n[0][1] * n[2][2];
+      inv[0][2] = n[0][1] * n[1][2] - n[0][2] * n[1][1];
+      inv[1][0] = n[1][2] * n[2][0] - n[1][0] * n[2][2];
+      inv[1][1] = n[0][0] * n[2][2] - n[0][2] * n[2][0];
+      inv[1][2] = n[0][2] * n[1][0] - n[0][0] * n[1][2];
+      inv[2][0] = n[1][0] * n[2][1] - n[1][1] * n[2][0];
+      inv[2][1] = n[0][1] * n[2][0] - n[0][0] * n[2][1];
+      inv[2][2] = n[0][0] * n[1][1] - n[0][1] * n[1][0];
+      float det = n[0][0] * inv[0][0] + n[0][1] * inv[1][0] + n[0][2] * inv[2][0];
+      for (int i = 0; i < 3; i++) {
+          for (int j = 0; j < 3; j++) {
+              inv[i][j] /= det;
+          }
+      }
+      // P = N^-1 B^T W, mode variance is the diagonal of N^-1
+      for (int i = 0; i < 3; i++) {
+          for (int c = 0; c < 4; c++) {
+              p[i][c] = 0;
+              for (int j = 0; j < 3; j++) {
+                  p[i][c] += inv[i][j] * basis[c][j] * w[c];
+              }
+          }
+          noiseFloor[i] = MIX_NOISE_SIGMAS * sqrtf(inv[i][i]);
+      }
+  }
+
+  /**
+   * mode amplitudes of the channels a, b, c, d with the noise floor subtracted (soft threshold),
+   * so a mode starts from zero as soon as it rises above the noise
+  */
+  void apply(int a, int b, int c, int d, float *modes) const {
+      for (int i = 0; i < 3; i++) {
+          float m = p[i][0] * a + p[i][1] * b + p[i][2] * c + p[i][3] * d;
+          modes[i] = copysignf(fmaxf(fabsf(m) - noiseFloor[i], 0.0f), m);
+      }
+  }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Latency compensation. Each output is extrapolated from its sample time to the expected
+// USB transmit time using a smoothed per-axis velocity. Header only so the host tools
+// (space_mouse_host/smpredict) replay recorded traces with exactly this code.
+
+// Axes with |value| below this are treated as at rest: no prediction, velocity estimate is reset.
+#define PREDICT_REST 12
+// Largest step the prediction may add to a value.
+#define PREDICT_MAX_DELTA 80
+// Exponential smoothing of the velocity estimate, 1.0 = raw finite difference.
+#define PREDICT_VEL_ALPHA 0.5f
+// Samples further apart than this restart the estimate (e.g. after the device was unmounted).
+#define PREDICT_MAX_GAP_US 50000
+
+class AxisPredictor {
+    float velocity = 0; // units per microsecond
+    int32_t last = 0;
+    int64_t lastUs = 0;
+    bool valid = false;
+
+public:
+  int32_t update(int32_t value, int64_t sampleUs, int64_t targetUs) {
+      int64_t dt = sampleUs - lastUs;
+      if (abs(value) < PREDICT_REST) {
+          valid = false;
+          velocity = 0;
+      } else if (!valid || dt <= 0 || dt > PREDICT_MAX_GAP_US) {
+          valid = true;
+          velocity = 0;
+      } else {
+          float v = (float)(value - last) / dt;
+          velocity = PREDICT_VEL_ALPHA * v + (1.0f - PREDICT_VEL_ALPHA) * velocity;
+      }
+      last = value;
+      lastUs = sampleUs;
+      if (!valid) {
+          return value;
+      }
+
+      int32_t delta = (int32_t)(velocity * (targetUs - sampleUs));
+      if (delta > PREDICT_MAX_DELTA) delta = PREDICT_MAX_DELTA;
+      if (delta < -PREDICT_MAX_DELTA) delta = -PREDICT_MAX_DELTA;
+      // Never predict through zero, a knob returning to rest must not overshoot to the other side.
+      if ((value > 0 && value + delta < 0) || (value < 0 && value + delta > 0)) {
+          return 0;
+      }
+      return value + delta;
+  }
+};
+
+class Predictor {
+    AxisPredictor axes[6];
+
+public:
+  // Replace values[6] (TX TY TZ RX RY RZ) sampled at sampleUs by their extrapolation to targetUs.
+  void apply(int16_t *values, int64_t sampleUs, int64_t targetUs) {
+      for (int i = 0; i < 6; i++) {
+          int32_t v = axes[i].update(values[i], sampleUs, targetUs);
+          values[i] = v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+      }
+  }
+};
@@ -16,25 +16,12 @@
 #include "driver/gpio.h"
 #include "esp_timer.h"
 #include "adcdata.h"
-#include "hal/wdt_hal.h"
-
-#define SPACE_MOUSE_PRO 1 
-#define SPACE_MOUSE_WIRELESS 2
-#define SPACE_MOUSE_ENTERPRISE 3
-
-// two events for translation and rotation
-#define SM_DEVICE  SPACE_MOUSE_PRO
-
-// single event for both translation and rotation
-// #define SM_DEVICE SPACE_MOUSE_WIRELESS
-
-// single event for both translation and rotation
-#define SM_DEVICE SPACE_MOUSE_ENTERPRISE
-
-#if SM_DEVICE == SPACE_MOUSE_PRO  || SM_DEVICE == SPACE_MOUSE_WIRELESS
-#define DEVICE_TYPE 66
-#else
-#define DEVICE_TYPE 12
+#include "hid_report.h"
+#include "hid_report_desc.h"
+#include "telemetry.h"
+#include "health.h"
+#if TRACE && !CONFIG_TINYUSB_CDC_ENABLED
+#error "TRACE needs CONFIG_TINYUSB_CDC_ENABLED"
 #endif
 
 static const char *TAG = "SM";
@@ -43,84 +30,30 @@ static const char *TAG = "SM";
 // This portion sets up the communication with the 3DConnexion software. The communication protocol is created here.
 // hidReportDescriptor webpage can be found here: https://eleccelerator.com/tutorial-about-usb-hid-report-descriptors/ 
 #if DEVICE_TYPE == 66
-#define TUD_HID_REPORT_DESC_SPACE_MOUSE \
-  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     )                 ,\
-  HID_USAGE      ( HID_USAGE_DESKTOP_MULTI_AXIS_CONTROLLER  )   ,\
-  HID_COLLECTION ( HID_COLLECTION_APPLICATION )                 ,\
-  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
-  HID_REPORT_ID(HID_ITF_PROTOCOL_KEYBOARD)                       \
-  HID_LOGICAL_MIN_N  ( -32768, 2                              ) ,\
-  HID_LOGICAL_MAX_N  ( 32767, 2                               ) ,\
-  HID_PHYSICAL_MIN_N  ( -32768, 2                             ) ,\
-  HID_PHYSICAL_MAX_N  ( 32767, 2                              ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_X                    ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_Y                    ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_Z                    ) ,\
-  HID_REPORT_SIZE    ( 16                                     ) ,\
-  HID_REPORT_COUNT   ( 3                                      ) ,\
-  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
-  HID_COLLECTION_END                                            ,\
-  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
-  HID_REPORT_ID(HID_ITF_PROTOCOL_MOUSE)                          \
-  HID_LOGICAL_MIN_N  ( -32768, 2                              ) ,\
-  HID_LOGICAL_MAX_N  ( 32767, 2                               ) ,\
-  HID_PHYSICAL_MIN_N  ( -32768, 2                             ) ,\
-  HID_PHYSICAL_MAX_N  ( 32767, 2                              ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_RX                   ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_RY                   ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_RZ                   ) ,\
-  HID_REPORT_SIZE    ( 16                                     ) ,\
-  HID_REPORT_COUNT   ( 3                                      ) ,\
-  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
-  HID_COLLECTION_END                                            ,\
-  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
-  HID_REPORT_ID(3)                                               \
-  HID_LOGICAL_MIN  ( 0                                        ) ,\
-  HID_LOGICAL_MAX  ( 1                                        ) ,\
-  HID_REPORT_SIZE    ( 1                                      ) ,\
-  HID_REPORT_COUNT   ( 32                                     ) ,\
-  HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                  ) ,\
-  HID_USAGE_MIN      (1                                       ) ,\
-  HID_USAGE_MAX      (32                                      ) ,\
-  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
-  HID_COLLECTION_END                                            ,\
-  HID_COLLECTION_END
+#define TUD_HID_REPORT_DESC_SPACE_MOUSE TUD_HID_REPORT_DESC_SPACE_MOUSE_SPLIT
 #else
-#define TUD_HID_REPORT_DESC_SPACE_MOUSE \
-  HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP     )                 ,\
-  HID_USAGE      ( HID_USAGE_DESKTOP_MULTI_AXIS_CONTROLLER  )   ,\
-  HID_COLLECTION ( HID_COLLECTION_APPLICATION )                 ,\
-  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
-  HID_REPORT_ID(HID_ITF_PROTOCOL_KEYBOARD)                       \
-  HID_LOGICAL_MIN_N  ( -32768, 2                              ) ,\
-  HID_LOGICAL_MAX_N  ( 32767, 2                               ) ,\
-  HID_PHYSICAL_MIN_N  ( -32768, 2                             ) ,\
-  HID_PHYSICAL_MAX_N  ( 32767, 2                              ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_X                    ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_Y                    ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_Z                    ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_RX                   ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_RY                   ) ,\
-  HID_USAGE          ( HID_USAGE_DESKTOP_RZ                   ) ,\
-  HID_REPORT_SIZE    ( 16                                     ) ,\
-  HID_REPORT_COUNT   ( 6                                      ) ,\
-  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
-  HID_COLLECTION_END                                            ,\
-  HID_COLLECTION ( HID_COLLECTION_PHYSICAL )                    ,\
-  HID_REPORT_ID(3)                                               \
-  HID_LOGICAL_MIN  ( 0                                        ) ,\
-  HID_LOGICAL_MAX  ( 1                                        ) ,\
-  HID_REPORT_SIZE    ( 1                                      ) ,\
-  HID_REPORT_COUNT   ( 32                                     ) ,\
-  HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                  ) ,\
-  HID_USAGE_MIN      (1                                       ) ,\
-  HID_USAGE_MAX      (32                                      ) ,\
-  HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ) ,\
-  HID_COLLECTION_END                                            ,\
-  HID_COLLECTION_END
+#define TUD_HID_REPORT_DESC_SPACE_MOUSE TUD_HID_REPORT_DESC_SPACE_MOUSE_COMBINED
 #endif
 
+// Interface numbers. With TRACE the device is a composite HID + CDC-ACM device,
+// the CDC pair (control + data) follows the HID interface.
+enum {
+    ITF_NUM_HID = 0,
+#if TRACE
+    ITF_NUM_CDC,
+    ITF_NUM_CDC_DATA,
+#endif
+    ITF_NUM_TOTAL
+};
+
+#if TRACE
+#define TUSB_DESC_TOTAL_LEN      (TUD_CONFIG_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
+#else
 #define TUSB_DESC_TOTAL_LEN      (TUD_CONFIG_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN)
+#endif
+
+// HID IN endpoint polling interval. A report waits on average half of it before the host picks it up.
+#define HID_POLL_INTERVAL_MS 10
 
 /**
  * @brief HID report descriptor
@@ -137,26 +70,31 @@ const uint8_t hid_report_descriptor[] = {
 /**
  * @brief String descriptor
  */
-const char* hid_string_descriptor[5] = {
+const char* hid_string_descriptor[6] = {
     // array of pointer to string descriptors
     (char[]){0x09, 0x04},  // 0: is supported language is English (0x0409)
     "3Dconnexion",                // 1: Manufacturer
     "Spacemouse",  // 2: Product
     "K2343432345348",             // 3: Serials, should use chip ID
     "Space mouse HID interface",  // 4: HID
+    "Space mouse trace",          // 5: CDC trace stream
 };
 
 /**
  * @brief Configuration descriptor
  *
- * This is a simple configuration descriptor that defines 1 configuration and 1 HID interface
+ * One configuration with the HID interface and, if TRACE is enabled, a CDC-ACM interface pair
  */
 static const uint8_t hid_configuration_descriptor[] = {
     // Configuration number, interface count, string index, total length, attribute, power in mA
-    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
 
     // Interface number, string index, boot protocol, report descriptor len, EP In address, size & polling interval
-    TUD_HID_DESCRIPTOR(0, 4, false, sizeof(hid_report_descriptor), 0x81, 16, 10),
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 4, false, sizeof(hid_report_descriptor), 0x81, 16, HID_POLL_INTERVAL_MS),
+#if TRACE
+    // Interface number, string index, EP notification address and size, EP data address (out, in) and size
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 5, 0x82, 8, 0x03, 0x83, 64),
+#endif
 };
 
 /********* TinyUSB HID callbacks ***************/
@@ -192,47 +130,117 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
 
 /********* Application ***************/
 
-void sendHidReport(int rx, int ry, int rz, int x, int y, int z) {
-#if DEVICE_TYPE == 66
-    uint8_t trans[6] = { static_cast<uint8_t>(x & 0xFF) , static_cast<uint8_t>(x >> 8), static_cast<uint8_t>(y & 0xFF), static_cast<uint8_t>(y >> 8), static_cast<uint8_t>(z & 0xFF), static_cast<uint8_t>(z >> 8) };
-    tud_hid_report(1, trans, 6);
-
-    uint8_t rot[6] = { static_cast<uint8_t>(rx & 0xFF), static_cast<uint8_t>(rx >> 8), static_cast<uint8_t>(ry & 0xFF), static_cast<uint8_t>(ry >> 8), static_cast<uint8_t>(rz & 0xFF), static_cast<uint8_t>(rz >> 8) };
-    tud_hid_report(2, rot, 6);
-#else                                      
-    uint8_t trans[12] = { static_cast<uint8_t>(x & 0xFF) , static_cast<uint8_t>(x >> 8), static_cast<uint8_t>(y & 0xFF), static_cast<uint8_t>(y >> 8), static_cast<uint8_t>(z & 0xFF), static_cast<uint8_t>(z >> 8),
-        static_cast<uint8_t>(rx & 0xFF), static_cast<uint8_t>(rx >> 8),                      static_cast<uint8_t>(ry & 0xFF), static_cast<uint8_t>(ry >> 8), static_cast<uint8_t>(rz & 0xFF), static_cast<uint8_t>(rz >> 8) };
-    tud_hid_report(1, trans, 12);
-#endif
+/**
+ * Two report slots. The sampler writes the next frame into the slot that is not on the wire, the
+ * slot being sent stays untouched until TinyUSB reports the transfer complete. With DEVICE_TYPE 66
+ * the rotation report is sent from the completion of the translation report, the endpoint only
+ * takes one report at a time. A frame finished while a transfer is in flight waits as "ready",
+ * a newer frame replaces it.
+ */
+static SmReport txSlots[2];
+static int txBusy = -1;  // slot on the wire
+static int txReady = -1; // slot waiting for the endpoint
+static int txPart = 0;   // report of the busy slot being sent
+static portMUX_TYPE txLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void txStart(int slot, int part) {
+    uint8_t id;
+    uint16_t len;
+    const uint8_t *payload = txSlots[slot].report(part, id, len);
+    if (!tud_hid_report(id, payload, len)) {
+        // endpoint not available (suspended, reset), drop the frame
+        portENTER_CRITICAL(&txLock);
+        txBusy = -1;
+        portEXIT_CRITICAL(&txLock);
+    }
+}
 
-}                                     
-                                                                                                                   
-extern "C" void app_main(void)
-{                                                                                                                                                                                        
-    //-------------ADC Init---------------//
-    ADCData adcData;
-    adcData.adc_init();
+// Slot the sampler may write the next frame into.
+static SmReport &txAcquire() {
+    portENTER_CRITICAL(&txLock);
+    int slot = txBusy == 0 ? 1 : 0;
+    if (txReady == slot) {
+        txReady = -1;
+    }
+    portEXIT_CRITICAL(&txLock);
+    return txSlots[slot];
+}
 
-    // Read idle/centre positions for joysticks.
-    adcData.initCenterPoints();
+// Queue the slot returned by txAcquire(), starts the transfer if the endpoint is idle.
+static void txSubmit(SmReport &report) {
+    int slot = &report - txSlots;
+    bool start = false;
+    portENTER_CRITICAL(&txLock);
+    if (txBusy < 0) {
+        txBusy = slot;
+        txPart = 0;
+        start = true;
+    } else {
+        txReady = slot;
+    }
+    portEXIT_CRITICAL(&txLock);
+    if (start) {
+        txStart(slot, 0);
+    }
+}
 
-    // Initialize button that will trigger HID reports
-    // const gpio_config_t boot_button_config = {
-    //     .pin_bit_mask = BIT64(APP_BUTTON),
-    //     .mode = GPIO_MODE_INPUT,
-    //     .intr_type = GPIO_INTR_DISABLE,
-    //     .pull_up_en = true,
-    //     .pull_down_en = false,
-    // };
-    // ESP_ERROR_CHECK(gpio_config(&boot_button_config));
+// Invoked when sent REPORT successfully to host
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len)
+{
+    (void) instance;
+    (void) report;
+    (void) len;
+    int slot, part;
+    telemetry_boot_phase(BOOT_FIRST_REPORT);
+    portENTER_CRITICAL(&txLock);
+    if (txBusy >= 0 && txPart + 1 < SmReport::REPORT_COUNT) {
+        txPart++;
+    } else {
+        txBusy = txReady;
+        txReady = -1;
+        txPart = 0;
+    }
+    slot = txBusy;
+    part = txPart;
+    portEXIT_CRITICAL(&txLock);
+    if (slot >= 0) {
+        txStart(slot, part);
+    }
+}
+
+// Invoked when device is mounted (configured)
+void tud_mount_cb(void)
+{
+    telemetry_boot_phase(BOOT_USB_MOUNTED);
+}
 
+// Invoked when device is unmounted, a transfer in flight will never complete
+void tud_umount_cb(void)
+{
+    portENTER_CRITICAL(&txLock);
+    txBusy = -1;
+    txReady = -1;
+    portEXIT_CRITICAL(&txLock);
+}
+
+extern "C" void app_main(void)
+{                                                                                                                                                                                        
+    // USB goes first: enumeration runs in the TinyUSB task while this task calibrates, the loop
+    // below starts reporting once both are done.
 static tusb_desc_device_t descriptor_config = {
     .bLength = sizeof(descriptor_config),
     .bDescriptorType = TUSB_DESC_DEVICE,
     .bcdUSB = 0x0200,
+#if TRACE
+    // composite device, CDC needs the interface association descriptor
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+#else
     .bDeviceClass = TUSB_CLASS_HID,
     .bDeviceSubClass = 0,//MISC_SUBCLASS_COMMON,
     .bDeviceProtocol = 0,//MISC_PROTOCOL_IAD,
+#endif
     .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
 
 #if SM_DEVICE == SPACE_MOUSE_PRO
@@ -264,15 +272,52 @@ static tusb_desc_device_t descriptor_config = {
     };
 
     ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
+#if TRACE
+    trace_init();
+#endif
     ESP_LOGI(TAG, "USB initialization DONE");
 
+    //-------------ADC Init---------------//
+#if STATIC_ALLOC
+    static ADCData adcData; // keeps the main task stack small
+#else
+    ADCData adcData;
+#endif
+    adcData.adc_init();
+    telemetry_boot_phase(BOOT_ADC_READY);
+
+    // Read idle/centre positions for joysticks.
+    adcData.initCenterPoints();
+    telemetry_boot_phase(BOOT_CALIBRATED);
+
+    // subscribing to the task watchdog allocates, do it before the heap is sealed (and after the
+    // calibration, which may take longer than the watchdog timeout)
+    HealthMonitor health;
+    health.start();
+
+    // all drivers, tasks and buffers exist now, the loop below must not allocate
+    telemetry_seal_heap();
+
+    // Initialize button that will trigger HID reports
+    // const gpio_config_t boot_button_config = {
+    //     .pin_bit_mask = BIT64(APP_BUTTON),
+    //     .mode = GPIO_MODE_INPUT,
+    //     .intr_type = GPIO_INTR_DISABLE,
+    //     .pull_up_en = true,
+    //     .pull_down_en = false,
+    // };
+    // ESP_ERROR_CHECK(gpio_config(&boot_button_config));
+
+    bool bootLogged = false;
+    int64_t nextBudgetUs = 0;
     while (1) {
         bool mounted = tud_mounted();
         // ESP_LOGI(TAG, "loop mounted: %d", mounted);
         if (mounted) {
 
             // int64_t before = esp_timer_get_time();
-            adcData.readAllFromJoystick(5);
+            // on failure the last good values stay in place and go through the pipeline again
+            bool fresh = adcData.readAllFromJoystick(FRAME_SAMPLES) == ESP_OK;
             // int64_t elapsed = esp_timer_get_time() - before;
 
             adcData.interpolateTo1024();
@@ -281,9 +326,35 @@ static tusb_desc_device_t descriptor_config = {
             if (DEBUG>0) {
                 adcData.dbg_prints();
             }
+#if PREDICT
+            adcData.predictLatency(esp_timer_get_time() + HID_POLL_INTERVAL_MS*1000/2);
+#endif
+#if TRACE
+            TraceStagesFrame frame;
+            adcData.fillTrace(frame);
+            trace_push(frame);
+#endif
+
+            SmReport &report = txAcquire();
+            adcData.writeReport(report);
+            txSubmit(report);
+            telemetry_count(TM_FRAMES);
+            health.frameDone(fresh, adcData.sampleTimeUs, esp_timer_get_time());
 
-            sendHidReport(adcData.rotX, adcData.rotY, adcData.rotZ, adcData.transX, adcData.transY, adcData.transZ);
+            if (!bootLogged && telemetry_boot_us(BOOT_FIRST_REPORT)) {
+                telemetry_log_boot();
+                bootLogged = true;
+            }
+        } else {
+            health.idle();
         }
-        vTaskDelay(pdMS_TO_TICKS(5));
+#if STATIC_ALLOC
+        // also while unmounted, a stuck enumeration is when the report is most wanted
+        if (esp_timer_get_time() >= nextBudgetUs) {
+            telemetry_log_budget();
+            nextBudgetUs = esp_timer_get_time() + BUDGET_REPORT_PERIOD_MS * 1000LL;
+        }
+#endif
+        vTaskDelay(LOOP_DELAY_TICKS);
     }
 }
@@ -0,0 +1,86 @@
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "const.h"
+#include "spi_adc.h"
+
+// internal RAM, word aligned, usable by the SPI DMA
+DMA_ATTR static Mcp3208Frame spiAdcFrame;
+
+SpiAdc::SpiAdc() {
+    dev = NULL;
+    frame = NULL;
+    inFlight = 0;
+    memset(trans, 0, sizeof(trans));
+}
+
+void SpiAdc::init() {
+    spi_bus_config_t buscfg = {};
+    buscfg.mosi_io_num = SPI_ADC_MOSI;
+    buscfg.miso_io_num = SPI_ADC_MISO;
+    buscfg.sclk_io_num = SPI_ADC_SCLK;
+    buscfg.quadwp_io_num = -1;
+    buscfg.quadhd_io_num = -1;
+    buscfg.max_transfer_sz = sizeof(Mcp3208Frame);
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO));
+
+    spi_device_interface_config_t devcfg = {};
+    devcfg.mode = 0;
+    devcfg.clock_speed_hz = SPI_ADC_CLOCK_HZ;
+    devcfg.spics_io_num = SPI_ADC_CS;
+    devcfg.queue_size = MCP3208_CHANNELS;
+    ESP_ERROR_CHECK(spi_bus_add_device(SPI2_HOST, &devcfg, &dev));
+
+    frame = &spiAdcFrame;
+    frame->init();
+    for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+        trans[ch].length = MCP3208_XFER_BYTES * 8;
+        trans[ch].tx_buffer = frame->tx[ch];
+        trans[ch].rx_buffer = frame->rx[ch];
+    }
+    // keep the bus for the whole run, saves the arbitration on every queued transfer
+    ESP_ERROR_CHECK(spi_device_acquire_bus(dev, portMAX_DELAY));
+}
+
+esp_err_t SpiAdc::collect(TickType_t wait) {
+    while (inFlight > 0) {
+        spi_transaction_t *done;
+        esp_err_t err = spi_device_get_trans_result(dev, &done, wait);
+        if (err != ESP_OK) {
+            return err;
+        }
+        inFlight--;
+    }
+    return ESP_OK;
+}
+
+esp_err_t SpiAdc::readFrame(int *values) {
+    // Transfers left over from a timed out frame still belong to the driver and would shift this
+    // frame: collect them first, and fail this frame too while the bus is still stuck.
+    esp_err_t err = collect(pdMS_TO_TICKS(SPI_ADC_TIMEOUT_MS));
+    if (err != ESP_OK) {
+        return err;
+    }
+    for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+        err = spi_device_queue_trans(dev, &trans[ch], 0);
+        if (err != ESP_OK) {
+            break;
+        }
+        inFlight++;
+    }
+    esp_err_t e = collect(pdMS_TO_TICKS(SPI_ADC_TIMEOUT_MS));
+    if (err == ESP_OK) {
+        err = e;
+    }
+    if (err == ESP_OK) {
+        frame->decode(values);
+    }
+    return err;
+}
+
+void SpiAdc::done() {
+    collect(pdMS_TO_TICKS(SPI_ADC_TIMEOUT_MS));
+    spi_device_release_bus(dev);
+    ESP_ERROR_CHECK(spi_bus_remove_device(dev));
+    ESP_ERROR_CHECK(spi_bus_free(SPI2_HOST));
+    frame = NULL;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "driver/spi_master.h"
+#include "mcp3208.h"
+
+/**
+ * External MCP3208 on the FSPI bus. Every frame queues the 8 channel transfers at once and lets
+ * the DMA run them back to back, the CPU only waits for the results.
+ */
+class SpiAdc {
+    spi_device_handle_t dev;
+    spi_transaction_t trans[MCP3208_CHANNELS];
+    Mcp3208Frame *frame; // DMA capable buffers
+    int inFlight;        // queued transfers whose results were not collected yet
+
+    // Collect the in flight results, ESP_ERR_TIMEOUT if they are not all back within wait.
+    esp_err_t collect(TickType_t wait);
+
+public:
+  SpiAdc();
+
+  void init();
+
+  // Read all channels once, values[i] = MCP3208 CHi, 0..4095. Never blocks longer than about
+  // 2 x SPI_ADC_TIMEOUT_MS, a stuck bus returns ESP_ERR_TIMEOUT.
+  esp_err_t readFrame(int *values);
+
+  void done();
+};
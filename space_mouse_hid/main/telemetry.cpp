@@ -0,0 +1,97 @@
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "telemetry.h"
+
+static const char *TAG = "SM_BOOT";
+static const char *BUDGET_TAG = "SM_BUDGET";
+
+// Linker script symbols bounding the static RAM sections.
+extern int _data_start, _data_end, _bss_start, _bss_end;
+
+static std::atomic<uint32_t> bootUs[BOOT_PHASES];
+static std::atomic<uint32_t> counters[TM_COUNTERS];
+// Touched by the heap hook, which may run with the flash cache disabled: plain words in DRAM,
+// no std::atomic (on the single core S2 its read-modify-write goes through libatomic in flash).
+// A count lost to an interrupting allocation is acceptable, any nonzero value is a finding.
+static volatile uint32_t heapAllocs;
+static volatile bool heapSealed;
+
+void telemetry_boot_phase(BootPhase phase) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint32_t expected = 0;
+    // 0 means not reached, a phase at exactly 0 us can not happen after startup
+    bootUs[phase].compare_exchange_strong(expected, now, std::memory_order_relaxed);
+}
+
+uint32_t telemetry_boot_us(BootPhase phase) {
+    return bootUs[phase].load(std::memory_order_relaxed);
+}
+
+void telemetry_count(TelemetryCounter counter, uint32_t n) {
+    counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void telemetry_max(TelemetryCounter counter, uint32_t value) {
+    uint32_t cur = counters[counter].load(std::memory_order_relaxed);
+    while (value > cur && !counters[counter].compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+    }
+}
+
+void telemetry_log_boot() {
+    ESP_LOGI(TAG, "adc ready %lu us, calibrated %lu us, mounted %lu us, first report %lu us",
+        (unsigned long)telemetry_boot_us(BOOT_ADC_READY), (unsigned long)telemetry_boot_us(BOOT_CALIBRATED),
+        (unsigned long)telemetry_boot_us(BOOT_USB_MOUNTED), (unsigned long)telemetry_boot_us(BOOT_FIRST_REPORT));
+}
+
+void telemetry_seal_heap() {
+    heapSealed = true;
+}
+
+#if CONFIG_HEAP_USE_HOOKS
+// Called by the heap on every allocation, from any task or ISR, also while the flash cache is
+// disabled: IRAM, and only DRAM data. Only counts, must stay cheap.
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    (void) ptr;
+    (void) size;
+    (void) caps;
+    if (heapSealed) {
+        heapAllocs = heapAllocs + 1;
+    }
+}
+#endif
+
+void telemetry_log_budget() {
+#if configUSE_TRACE_FACILITY
+    static TaskStatus_t tasks[16]; // static: the report itself must not grow the caller's stack much
+    UBaseType_t n = uxTaskGetSystemState(tasks, sizeof(tasks) / sizeof(tasks[0]), NULL);
+    for (UBaseType_t i = 0; i < n; i++) {
+        // ESP-IDF stacks are in bytes
+        ESP_LOGI(BUDGET_TAG, "task %s free %u", tasks[i].pcTaskName, (unsigned)tasks[i].usStackHighWaterMark);
+    }
+#else
+    ESP_LOGI(BUDGET_TAG, "task %s free %u", pcTaskGetName(NULL), (unsigned)uxTaskGetStackHighWaterMark(NULL));
+#endif
+    ESP_LOGI(BUDGET_TAG, "static data %u bss %u", (unsigned)((char *)&_data_end - (char *)&_data_start),
+        (unsigned)((char *)&_bss_end - (char *)&_bss_start));
+    ESP_LOGI(BUDGET_TAG, "heap free %u min %u allocs %lu", (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+        (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+        (unsigned long)heapAllocs);
+}
+
+void telemetry_fill(TraceTelemetryFrame &frame) {
+    frame.hdr.magic = TRACE_MAGIC;
+    frame.hdr.type = TRACE_FRAME_TELEMETRY;
+    frame.hdr.len = sizeof(TraceTelemetryFrame) - sizeof(TraceHeader);
+    for (int i = 0; i < BOOT_PHASES; i++) {
+        frame.bootUs[i] = bootUs[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < TM_COUNTERS; i++) {
+        frame.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    frame.counters[TM_HEAP_ALLOCS] = heapAllocs;
+}
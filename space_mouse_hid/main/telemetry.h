@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include "trace.h"
+
+// Boot phases, timestamped once in esp_timer microseconds (esp_timer starts early in the
+// application startup, the second stage bootloader is not included).
+enum BootPhase {
+    BOOT_ADC_READY,    // adc_init() done
+    BOOT_CALIBRATED,   // initCenterPoints() done
+    BOOT_USB_MOUNTED,  // host configured the device
+    BOOT_FIRST_REPORT, // first HID report transfer completed
+    BOOT_PHASES
+};
+
+// Running counters. New counters go at the end, the host decoder names them by position.
+enum TelemetryCounter {
+    TM_FRAMES,        // frames through the pipeline
+    TM_TRACE_DROPPED, // trace frames dropped on the device (ring full or no host)
+    TM_HEAP_ALLOCS,   // heap allocations after telemetry_seal_heap(), counted by the heap hook (CONFIG_HEAP_USE_HOOKS)
+    TM_ADC_ERRORS,       // failed ADC reads, including ones that succeeded on retry
+    TM_HELD_FRAMES,      // frames sent with the last good ADC values because the read failed
+    TM_ADC_RECOVERIES,   // fresh frames again after holding
+    TM_DEADLINE_MISSES,  // fresh frames handed to USB later than FRAME_DEADLINE_US after their sample time
+    TM_FRAME_GAP_MAX_US, // longest gap between two frames while mounted, loop period check (a maximum)
+    TM_HELD_MS,          // time spent holding the last good ADC values, first held frame to recovery
+    TM_LATENCY_MAX_US,   // longest sample to USB hand-off latency of a fresh frame (a maximum)
+    TM_COUNTERS
+};
+
+typedef struct __attribute__((packed)) {
+    TraceHeader hdr;
+    uint32_t bootUs[BOOT_PHASES]; // 0 if the phase was not reached yet
+    uint32_t counters[TM_COUNTERS];
+} TraceTelemetryFrame;
+
+// Record the time of a boot phase, only the first call per phase counts.
+void telemetry_boot_phase(BootPhase phase);
+
+uint32_t telemetry_boot_us(BootPhase phase);
+
+void telemetry_count(TelemetryCounter counter, uint32_t n = 1);
+
+// Raise a maximum kept in a counter slot.
+void telemetry_max(TelemetryCounter counter, uint32_t value);
+
+// Log all boot phase times.
+void telemetry_log_boot();
+
+// End of boot: from here on every heap allocation is counted in TM_HEAP_ALLOCS.
+void telemetry_seal_heap();
+
+/**
+ * Log the RAM budget: free stack (high-water mark) of every task, static .data/.bss, heap.
+ * One "SM_BUDGET" line per item, parsed by tools/budget_check.py. Task stacks need
+ * CONFIG_FREERTOS_USE_TRACE_FACILITY.
+ */
+void telemetry_log_budget();
+
+// Snapshot of boot times and counters, header magic/type/len filled, seq/timestamp left to the caller.
+void telemetry_fill(TraceTelemetryFrame &frame);
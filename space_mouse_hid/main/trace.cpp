@@ -0,0 +1,105 @@
+#include "trace.h"
+// The CDC-ACM driver is only built with CONFIG_TINYUSB_CDC_ENABLED, which only the trace build sets.
+#if TRACE
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "tinyusb.h"
+#include "tusb_cdc_acm.h"
+#include "telemetry.h"
+
+static const char *TAG = "SM_TRACE";
+
+static SpscRing<TraceStagesFrame, TRACE_RING_LEN> traceRing;
+static std::atomic<uint32_t> traceSeq{0};
+static std::atomic<uint32_t> traceDropped{0};
+
+#if STATIC_ALLOC
+#define TRACE_TASK_STACK 2048
+#else
+#define TRACE_TASK_STACK 3072
+#endif
+static StackType_t traceTaskStack[TRACE_TASK_STACK];
+static StaticTask_t traceTaskBuffer;
+
+// Telemetry snapshot period, the snapshot is small and keeps the boot times visible to a late listener.
+#define TRACE_TELEMETRY_PERIOD_US 1000000
+
+bool trace_push(TraceStagesFrame &frame) {
+    frame.hdr.magic = TRACE_MAGIC;
+    frame.hdr.type = TRACE_FRAME_STAGES;
+    frame.hdr.len = sizeof(TraceStagesFrame) - sizeof(TraceHeader);
+    frame.hdr.seq = traceSeq.fetch_add(1, std::memory_order_relaxed);
+    frame.hdr.dropped = traceDropped.load(std::memory_order_relaxed);
+    if (!traceRing.push(frame)) {
+        traceDropped.fetch_add(1, std::memory_order_relaxed);
+        telemetry_count(TM_TRACE_DROPPED);
+        return false;
+    }
+    return true;
+}
+
+uint32_t trace_dropped() {
+    return traceDropped.load(std::memory_order_relaxed);
+}
+
+// Queue one whole frame. Never queue a partial frame, the host decoder would have to resync.
+static void trace_write(const void *frame, size_t len) {
+    while (tud_cdc_n_write_available(TINYUSB_CDC_ACM_0) < len) {
+        tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+        vTaskDelay(1);
+    }
+    tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (const uint8_t *)frame, len);
+    tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
+}
+
+// Drains the ring into the CDC TX FIFO. Only this task ever waits; the sampler just drops frames
+// when the host reads slower than we produce. A telemetry snapshot goes out every
+// TRACE_TELEMETRY_PERIOD_US in between.
+static void trace_task(void *arg) {
+    TraceStagesFrame frame;
+    TraceTelemetryFrame telemetry;
+    uint32_t telemetrySeq = 0;
+    int64_t nextTelemetryUs = 0;
+    while (1) {
+        bool connected = tud_cdc_n_connected(TINYUSB_CDC_ACM_0);
+        int64_t now = esp_timer_get_time();
+        if (connected && now >= nextTelemetryUs) {
+            telemetry_fill(telemetry);
+            telemetry.hdr.seq = telemetrySeq++;
+            telemetry.hdr.timestampUs = (uint32_t)now;
+            telemetry.hdr.dropped = traceDropped.load(std::memory_order_relaxed);
+            trace_write(&telemetry, sizeof(telemetry));
+            nextTelemetryUs = now + TRACE_TELEMETRY_PERIOD_US;
+        }
+        if (!traceRing.pop(frame)) {
+            vTaskDelay(1);
+            continue;
+        }
+        if (!connected) {
+            // nobody listening, counted like a full ring so the host does not blame the transfer for the gap
+            traceDropped.fetch_add(1, std::memory_order_relaxed);
+            telemetry_count(TM_TRACE_DROPPED);
+            continue;
+        }
+        trace_write(&frame, sizeof(frame));
+    }
+}
+
+void trace_init() {
+    tinyusb_config_cdcacm_t acm_cfg = {
+        .usb_dev = TINYUSB_USBDEV_0,
+        .cdc_port = TINYUSB_CDC_ACM_0,
+        .rx_unread_buf_sz = 64,
+        .callback_rx = NULL,
+        .callback_rx_wanted_char = NULL,
+        .callback_line_state_changed = NULL,
+        .callback_line_coding_changed = NULL
+    };
+    ESP_ERROR_CHECK(tusb_cdc_acm_init(&acm_cfg));
+    // Same priority as app_main, the writer runs in the gaps while the sampler sleeps between frames.
+    xTaskCreateStatic(trace_task, "sm_trace", TRACE_TASK_STACK, NULL, 1, traceTaskStack, &traceTaskBuffer);
+    ESP_LOGI(TAG, "trace stream on CDC-ACM 0, frame %d bytes", (int)sizeof(TraceStagesFrame));
+}
+#endif // TRACE
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "const.h"
+
+// Binary trace stream sent over the CDC-ACM interface when TRACE is enabled.
+// Every frame starts with TRACE_MAGIC, the frame type and the payload length,
+// so the host decoder (tools/trace2csv.py) can resynchronise after a partial read.
+#define TRACE_MAGIC 0x4D53 // "SM" on the wire (little endian)
+
+#define TRACE_FRAME_STAGES 1
+#define TRACE_FRAME_TELEMETRY 2 // TraceTelemetryFrame, see telemetry.h
+
+// Number of frames buffered between the sampler and the CDC writer. Must be a power of two.
+// The static profile spends the RAM saved on task stacks here.
+#if STATIC_ALLOC
+#define TRACE_RING_LEN 128
+#else
+#define TRACE_RING_LEN 32
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;        // TRACE_MAGIC
+    uint8_t  type;         // TRACE_FRAME_*
+    uint8_t  len;          // payload bytes following this header
+    uint32_t seq;          // incremented for every frame offered to the ring, dropped or not
+    uint32_t timestampUs;  // esp_timer time of the ADC sample, low 32 bits
+    uint32_t dropped;      // total frames dropped on the device: ring full, or no host connected
+} TraceHeader;
+
+typedef struct __attribute__((packed)) {
+    TraceHeader hdr;
+    int16_t raw[8];        // averaged ADC reads, pin order AX..DY
+    int16_t centered[8];   // after interpolateTo1024()
+    int16_t deadzoned[8];  // after filterDeadZone()
+    int16_t mixed[6];      // TX TY TZ RX RY RZ after calcRotTrans()
+    int16_t predicted[6];  // TX TY TZ RX RY RZ after predictLatency(), as sent to the host
+} TraceStagesFrame;
+
+/**
+ * Single producer / single consumer ring. push() is called from the sampler and never blocks,
+ * pop() is called from the trace writer task. Indices are free running, N must be a power of two.
+ */
+template<typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "SpscRing length must be a power of two");
+    T slots[N];
+    std::atomic<uint32_t> head{0}; // written by producer
+    std::atomic<uint32_t> tail{0}; // written by consumer
+
+public:
+  bool push(const T &item) {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) >= N) {
+          return false;
+      }
+      slots[h & (N - 1)] = item;
+      head.store(h + 1, std::memory_order_release);
+      return true;
+  }
+
+  bool pop(T &item) {
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == t) {
+          return false;
+      }
+      item = slots[t & (N - 1)];
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+  }
+};
+
+// Install the CDC-ACM port and start the writer task. Call after tinyusb_driver_install().
+void trace_init();
+
+// Stamp the header (all but timestampUs) and queue the frame. Returns false (and counts a drop) if the ring is full.
+bool trace_push(TraceStagesFrame &frame);
+
+// Total frames dropped so far.
+uint32_t trace_dropped();
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# Check the RAM budget report of the static allocation profile (see main/telemetry.h) against a budget.
+#
+#   idf.py -p PORT monitor | tee boot.log
+#   python tools/budget_check.py boot.log [--budget tools/budget.json]
+#
+# The firmware logs one report every BUDGET_REPORT_PERIOD_MS, the last complete one is checked.
+# Prints a table of every task and the static/heap figures, exit status 1 if anything is over budget.
+import argparse
+import json
+import os
+import re
+import sys
+
+LINE = re.compile(r'SM_BUDGET: (.*?)\s*(\x1b\[0m)?$')
+TASK = re.compile(r'task (.+) free (\d+)$')
+STATIC = re.compile(r'static data (\d+) bss (\d+)$')
+HEAP = re.compile(r'heap free (\d+) min (\d+) allocs (\d+)$')
+
+
+def reports(lines):
+    """Yield one dict per complete report, the heap line closes a report."""
+    report = {'tasks': {}}
+    for line in lines:
+        m = LINE.search(line.rstrip('\r\n'))
+        if not m:
+            continue
+        item = m.group(1)
+        m = TASK.match(item)
+        if m:
+            report['tasks'][m.group(1)] = int(m.group(2))
+            continue
+        m = STATIC.match(item)
+        if m:
+            report['data'], report['bss'] = int(m.group(1)), int(m.group(2))
+            continue
+        m = HEAP.match(item)
+        if m:
+            report['heap_free'], report['heap_min'], report['heap_allocs'] = (int(v) for v in m.groups())
+            yield report
+            report = {'tasks': {}}
+
+
+def main():
+    default_budget = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'budget.json')
+    parser = argparse.ArgumentParser(description='Check the space mouse RAM budget report')
+    parser.add_argument('log', help='captured monitor output, - for stdin')
+    parser.add_argument('--budget', default=default_budget, help='budget JSON, default tools/budget.json')
+    args = parser.parse_args()
+
+    with open(args.budget) as f:
+        budget = json.load(f)
+    log = sys.stdin if args.log == '-' else open(args.log, errors='replace')
+    last = None
+    count = 0
+    for last in reports(log):
+        count += 1
+    if last is None:
+        print('no complete SM_BUDGET report found (built with sdkconfig.static?)', file=sys.stderr)
+        return 2
+
+    failures = 0
+
+    def check(name, value, limit, ok):
+        nonlocal failures
+        status = 'ok' if ok else 'OVER'
+        failures += not ok
+        print('%-24s %8d %8s  %s' % (name, value, limit, status))
+
+    print('last of %d reports' % count)
+    print('%-24s %8s %8s' % ('item', 'value', 'budget'))
+    task_min = budget.get('task_min_free', {})
+    for name, free in sorted(last['tasks'].items()):
+        limit = task_min.get(name, budget['task_min_free_default'])
+        check('stack free ' + name, free, '>=%d' % limit, free >= limit)
+    for name in sorted(set(task_min) - set(last['tasks'])):
+        print('%-24s %8s %8s  missing' % ('stack free ' + name, '-', '>=%d' % task_min[name]))
+    if 'data' in last:
+        static = last['data'] + last['bss']
+        check('static data+bss', static, '<=%d' % budget['static_ram_max'], static <= budget['static_ram_max'])
+    check('heap min free', last['heap_min'], '>=%d' % budget['heap_min_free'],
+          last['heap_min'] >= budget['heap_min_free'])
+    check('heap allocs after boot', last['heap_allocs'], '<=%d' % budget['heap_allocs_max'],
+          last['heap_allocs'] <= budget['heap_allocs_max'])
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
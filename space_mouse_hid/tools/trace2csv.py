@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# Decode the binary trace stream (see main/trace.h) into CSV.
+#
+#   python tools/trace2csv.py /dev/ttyACM0 > trace.csv
+#   python tools/trace2csv.py capture.bin -o trace.csv --telemetry telemetry.csv
+#
+# Frames are resynchronised on the magic word, so a capture may start or end mid frame.
+# Telemetry frames (boot phase times and counters, main/telemetry.h) go to a separate CSV,
+# the last one is summarised on stderr.
+import argparse
+import os
+import struct
+import sys
+import termios
+import tty
+
+TRACE_MAGIC = 0x4D53
+TRACE_FRAME_STAGES = 1
+TRACE_FRAME_TELEMETRY = 2
+
+# TraceHeader: magic, type, len, seq, timestampUs, dropped
+HEADER = struct.Struct('<HBBIII')
+# TraceStagesFrame payload: raw[8], centered[8], deadzoned[8], mixed[6], predicted[6]
+STAGES = struct.Struct('<8h8h8h6h6h')
+PAYLOADS = {TRACE_FRAME_STAGES: STAGES}
+
+# TraceTelemetryFrame payload: bootUs[BOOT_PHASES] then uint32 counters, the firmware may append
+# counters so the count follows from the payload length.
+BOOT_PHASES = ['adc_ready_us', 'calibrated_us', 'mounted_us', 'first_report_us']
+COUNTERS = ['frames', 'trace_dropped', 'heap_allocs', 'adc_errors', 'held_frames', 'adc_recoveries',
+            'deadline_misses', 'frame_gap_max_us', 'held_ms', 'latency_max_us']
+
+PINS = ['AX', 'AY', 'BX', 'BY', 'CX', 'CY', 'DX', 'DY']
+AXES = ['TX', 'TY', 'TZ', 'RX', 'RY', 'RZ']
+COLUMNS = (['seq', 'timestamp_us', 'dropped']
+           + ['raw_' + p for p in PINS]
+           + ['centered_' + p for p in PINS]
+           + ['deadzoned_' + p for p in PINS]
+           + AXES
+           + ['pred_' + a for a in AXES])
+
+
+def payload_struct(frame_type, length):
+    if frame_type == TRACE_FRAME_TELEMETRY:
+        if length < 4 * len(BOOT_PHASES) or length % 4:
+            return None
+        return struct.Struct('<%dI' % (length // 4))
+    return PAYLOADS.get(frame_type)
+
+
+def counter_names(count):
+    return COUNTERS[:count] + ['counter_%d' % i for i in range(len(COUNTERS), count)]
+
+
+def frames(chunks):
+    """Yield (header, payload values) tuples from an iterable of byte chunks."""
+    buf = bytearray()
+    magic = struct.pack('<H', TRACE_MAGIC)
+    for chunk in chunks:
+        buf += chunk
+        while True:
+            start = buf.find(magic)
+            if start < 0:
+                del buf[:-1]
+                break
+            del buf[:start]
+            if len(buf) < HEADER.size:
+                break
+            hdr = HEADER.unpack_from(buf)
+            payload = payload_struct(hdr[1], hdr[2])
+            if payload is None or hdr[2] != payload.size:
+                # not a frame start, skip this magic
+                del buf[:1]
+                continue
+            if len(buf) < HEADER.size + payload.size:
+                break
+            values = payload.unpack_from(buf, HEADER.size)
+            del buf[:HEADER.size + payload.size]
+            yield hdr, values
+
+
+def read_chunks(path):
+    fd = os.open(path, os.O_RDONLY)
+    try:
+        if os.isatty(fd):
+            tty.setraw(fd)
+            termios.tcflush(fd, termios.TCIFLUSH)
+        while True:
+            chunk = os.read(fd, 4096)
+            if not chunk:
+                return
+            yield chunk
+    finally:
+        os.close(fd)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert the space mouse trace stream to CSV')
+    parser.add_argument('input', help='CDC-ACM device (e.g. /dev/ttyACM0) or captured binary file')
+    parser.add_argument('-o', '--output', help='CSV file, default stdout')
+    parser.add_argument('--telemetry', help='CSV file for telemetry frames')
+    args = parser.parse_args()
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    out.write(','.join(COLUMNS) + '\n')
+    tel_out = open(args.telemetry, 'w') if args.telemetry else None
+    tel_columns = None
+    last_telemetry = None
+    count = 0
+    lost = 0
+    last_seq = None
+    last_dropped = 0
+    try:
+        for hdr, values in frames(read_chunks(args.input)):
+            _, frame_type, _, seq, ts, dropped = hdr
+            if frame_type == TRACE_FRAME_TELEMETRY:
+                # own sequence, not part of the stage frame accounting
+                last_telemetry = dict(zip(BOOT_PHASES + counter_names(len(values) - len(BOOT_PHASES)), values))
+                if tel_out:
+                    if tel_columns is None:
+                        tel_columns = ['timestamp_us'] + list(last_telemetry)
+                        tel_out.write(','.join(tel_columns) + '\n')
+                    tel_out.write(','.join(str(v) for v in (ts,) + values) + '\n')
+                continue
+            if last_seq is not None and seq != last_seq + 1:
+                # gaps not explained by the device drop counter were lost on the way to the host
+                lost += max(0, (seq - last_seq - 1) - (dropped - last_dropped))
+            last_seq, last_dropped = seq, dropped
+            out.write(','.join(str(v) for v in (seq, ts, dropped) + values) + '\n')
+            count += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out is not sys.stdout:
+            out.close()
+        if tel_out:
+            tel_out.close()
+    print('%d frames, %d dropped on device, %d lost in transfer' % (count, last_dropped, lost), file=sys.stderr)
+    if last_telemetry:
+        print('telemetry: ' + ', '.join('%s %d' % kv for kv in last_telemetry.items()), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include "hid_descriptor.h"
+
+// Short item prefix: bTag(4) bType(2) bSize(2)
+#define ITEM_TYPE_MAIN   0
+#define ITEM_TYPE_GLOBAL 1
+#define ITEM_TYPE_LOCAL  2
+
+#define MAIN_INPUT          0x8
+#define MAIN_OUTPUT         0x9
+#define MAIN_COLLECTION     0xA
+#define MAIN_FEATURE        0xB
+#define MAIN_END_COLLECTION 0xC
+
+#define GLOBAL_USAGE_PAGE   0x0
+#define GLOBAL_LOGICAL_MIN  0x1
+#define GLOBAL_LOGICAL_MAX  0x2
+#define GLOBAL_PHYSICAL_MIN 0x3
+#define GLOBAL_PHYSICAL_MAX 0x4
+#define GLOBAL_REPORT_SIZE  0x7
+#define GLOBAL_REPORT_ID    0x8
+#define GLOBAL_REPORT_COUNT 0x9
+#define GLOBAL_PUSH         0xA
+#define GLOBAL_POP          0xB
+
+#define LOCAL_USAGE     0x0
+#define LOCAL_USAGE_MIN 0x1
+#define LOCAL_USAGE_MAX 0x2
+
+uint16_t HidField::usage(uint32_t i) const {
+    if (usages.empty()) {
+        return 0;
+    }
+    return i < usages.size() ? usages[i] : usages.back();
+}
+
+const char *hid_usage_name(uint16_t page, uint16_t usage) {
+    if (page == HID_PAGE_DESKTOP) {
+        switch (usage) {
+            case HID_DESKTOP_X: return "X";
+            case HID_DESKTOP_Y: return "Y";
+            case HID_DESKTOP_Z: return "Z";
+            case HID_DESKTOP_RX: return "RX";
+            case HID_DESKTOP_RY: return "RY";
+            case HID_DESKTOP_RZ: return "RZ";
+        }
+    } else if (page == HID_PAGE_BUTTON) {
+        return "BUTTON";
+    }
+    return "?";
+}
+
+void HidDescriptor::warn(size_t pos, const std::string &msg) {
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "offset %zu: ", pos);
+    warnings.push_back(prefix + msg);
+}
+
+HidReport &HidDescriptor::reportFor(uint8_t id) {
+    for (auto &r : reports) {
+        if (r.id == id) {
+            return r;
+        }
+    }
+    reports.push_back(HidReport{id, 0, {}});
+    return reports.back();
+}
+
+const HidReport *HidDescriptor::find(uint8_t id) const {
+    for (auto &r : reports) {
+        if (r.id == id) {
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+bool HidDescriptor::parse(const uint8_t *data, size_t len) {
+    struct Globals {
+        uint16_t usagePage = 0;
+        int32_t logicalMin = 0, logicalMax = 0;
+        uint32_t reportSize = 0, reportCount = 0;
+        uint8_t reportId = 0;
+    };
+    Globals g;
+    std::vector<Globals> stack;
+    std::vector<uint16_t> usages;
+    uint32_t usageMin = 0;
+    bool haveUsageMin = false;
+    int depth = 0;
+    bool ok = true;
+
+    reports.clear();
+    warnings.clear();
+
+    size_t pos = 0;
+    while (pos < len) {
+        uint8_t prefix = data[pos];
+        if (prefix == 0xFE) {
+            warn(pos, "long items are not supported");
+            return false;
+        }
+        uint8_t size = prefix & 0x3;
+        if (size == 3) {
+            size = 4;
+        }
+        uint8_t type = (prefix >> 2) & 0x3;
+        uint8_t tag = prefix >> 4;
+        if (pos + 1 + size > len) {
+            warn(pos, "item runs past the end of the descriptor");
+            return false;
+        }
+        uint32_t uval = 0;
+        for (int i = 0; i < size; i++) {
+            uval |= (uint32_t)data[pos + 1 + i] << (8 * i);
+        }
+        int32_t sval = (int32_t)uval;
+        if (size == 1) {
+            sval = (int8_t)uval;
+        } else if (size == 2) {
+            sval = (int16_t)uval;
+        }
+
+        if (type == ITEM_TYPE_MAIN) {
+            switch (tag) {
+                case MAIN_INPUT: {
+                    if (g.reportSize == 0 || g.reportSize > 32) {
+                        // nothing to decode (0) or more than a value holds, the decoder can not use it
+                        warn(pos, "input item with report size " + std::to_string(g.reportSize)
+                            + ", only 1 to 32 bits are supported");
+                        ok = false;
+                    } else if (g.reportCount == 0) {
+                        warn(pos, "input item with zero report count");
+                    }
+                    if (g.logicalMin > g.logicalMax) {
+                        warn(pos, "logical minimum is greater than logical maximum");
+                    }
+                    // Logical range must be representable in reportSize bits.
+                    if (g.reportSize > 0 && g.reportSize < 32) {
+                        int64_t lo = g.logicalMin < 0 ? -(int64_t(1) << (g.reportSize - 1)) : 0;
+                        int64_t hi = g.logicalMin < 0 ? (int64_t(1) << (g.reportSize - 1)) - 1
+                                                      : (int64_t(1) << g.reportSize) - 1;
+                        if (g.logicalMin < lo || g.logicalMax > hi) {
+                            warn(pos, "logical range does not fit into report size " + std::to_string(g.reportSize));
+                        }
+                    }
+                    bool constant = uval & 0x1;
+                    if (!constant && usages.empty()) {
+                        warn(pos, "data input item without usages");
+                    } else if (!constant && usages.size() < g.reportCount && !haveUsageMin) {
+                        warn(pos, "report count " + std::to_string(g.reportCount) + " but only "
+                            + std::to_string(usages.size()) + " usages");
+                    }
+                    if (depth == 0) {
+                        warn(pos, "input item outside of a collection");
+                    }
+                    HidReport &r = reportFor(g.reportId);
+                    HidField f;
+                    f.usagePage = g.usagePage;
+                    f.usages = usages;
+                    f.logicalMin = g.logicalMin;
+                    f.logicalMax = g.logicalMax;
+                    f.reportSize = g.reportSize;
+                    f.reportCount = g.reportCount;
+                    f.bitOffset = r.bits;
+                    f.isConstant = constant;
+                    r.fields.push_back(f);
+                    r.bits += g.reportSize * g.reportCount;
+                    break;
+                }
+                case MAIN_OUTPUT:
+                case MAIN_FEATURE:
+                    // Not sent on the interrupt IN endpoint, nothing to decode.
+                    break;
+                case MAIN_COLLECTION:
+                    depth++;
+                    break;
+                case MAIN_END_COLLECTION:
+                    if (depth == 0) {
+                        warn(pos, "end collection without collection");
+                        ok = false;
+                    } else {
+                        depth--;
+                    }
+                    break;
+                default:
+                    warn(pos, "unknown main item");
+            }
+            usages.clear();
+            haveUsageMin = false;
+        } else if (type == ITEM_TYPE_GLOBAL) {
+            switch (tag) {
+                case GLOBAL_USAGE_PAGE: g.usagePage = uval; break;
+                case GLOBAL_LOGICAL_MIN: g.logicalMin = sval; break;
+                case GLOBAL_LOGICAL_MAX:
+                    // Logical maximum is only negative if the minimum is, otherwise take it unsigned.
+                    g.logicalMax = g.logicalMin < 0 ? sval : (int32_t)uval;
+                    break;
+                case GLOBAL_PHYSICAL_MIN:
+                case GLOBAL_PHYSICAL_MAX:
+                    break;
+                case GLOBAL_REPORT_SIZE: g.reportSize = uval; break;
+                case GLOBAL_REPORT_COUNT: g.reportCount = uval; break;
+                case GLOBAL_REPORT_ID:
+                    if (uval == 0) {
+                        warn(pos, "report ID 0 is reserved");
+                    }
+                    g.reportId = uval;
+                    break;
+                case GLOBAL_PUSH: stack.push_back(g); break;
+                case GLOBAL_POP:
+                    if (stack.empty()) {
+                        warn(pos, "pop without push");
+                    } else {
+                        g = stack.back();
+                        stack.pop_back();
+                    }
+                    break;
+                default:
+                    break;
+            }
+        } else if (type == ITEM_TYPE_LOCAL) {
+            switch (tag) {
+                case LOCAL_USAGE: usages.push_back(uval); break;
+                case LOCAL_USAGE_MIN:
+                    usageMin = uval;
+                    haveUsageMin = true;
+                    break;
+                case LOCAL_USAGE_MAX:
+                    if (!haveUsageMin || uval < usageMin) {
+                        warn(pos, "usage maximum without matching minimum");
+                    } else {
+                        for (uint32_t u = usageMin; u <= uval; u++) {
+                            usages.push_back(u);
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        pos += 1 + size;
+    }
+    if (depth != 0) {
+        warn(pos, "unterminated collection");
+        ok = false;
+    }
+    for (auto &r : reports) {
+        if (r.bits % 8) {
+            warn(pos, "report " + std::to_string(r.id) + " is not byte aligned");
+        }
+        if (r.id == 0 && reports.size() > 1) {
+            warn(pos, "mix of items with and without report ID");
+        }
+    }
+    return ok;
+}
+
+std::string HidDescriptor::describe() const {
+    std::string out;
+    char line[160];
+    for (auto &r : reports) {
+        snprintf(line, sizeof(line), "report %u: %zu bytes\n", r.id, r.byteLength());
+        out += line;
+        for (auto &f : r.fields) {
+            snprintf(line, sizeof(line), "  bit %3u: %u x %u bit, logical %d..%d, page 0x%02x%s:",
+                f.bitOffset, f.reportCount, f.reportSize, f.logicalMin, f.logicalMax, f.usagePage,
+                f.isConstant ? " const" : "");
+            out += line;
+            for (uint32_t i = 0; i < f.reportCount && !f.usages.empty(); i++) {
+                out += " ";
+                out += hid_usage_name(f.usagePage, f.usage(i));
+                if (f.usagePage == HID_PAGE_BUTTON) {
+                    out += std::to_string(f.usage(i));
+                }
+            }
+            out += "\n";
+        }
+    }
+    return out;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Usage pages and usages used by the space mouse descriptors.
+#define HID_PAGE_DESKTOP 0x01
+#define HID_PAGE_BUTTON  0x09
+
+#define HID_DESKTOP_X  0x30
+#define HID_DESKTOP_Y  0x31
+#define HID_DESKTOP_Z  0x32
+#define HID_DESKTOP_RX 0x33
+#define HID_DESKTOP_RY 0x34
+#define HID_DESKTOP_RZ 0x35
+
+/**
+ * One Input main item: reportCount fields of reportSize bits each, starting at bitOffset
+ * (counted after the report ID byte).
+ */
+struct HidField {
+    uint16_t usagePage;
+    std::vector<uint16_t> usages; // one per field, last usage repeats if the list is shorter
+    int32_t logicalMin;
+    int32_t logicalMax;
+    uint32_t reportSize;
+    uint32_t reportCount;
+    uint32_t bitOffset;
+    bool isConstant;
+
+    bool isSigned() const { return logicalMin < 0; }
+    // The decoder handles fields of 1 to 32 bits, parse() rejects descriptors with others.
+    bool sizeSupported() const { return reportSize >= 1 && reportSize <= 32; }
+    uint16_t usage(uint32_t i) const;
+};
+
+struct HidReport {
+    uint8_t id;
+    uint32_t bits; // payload size without the report ID byte
+    std::vector<HidField> fields;
+
+    size_t byteLength() const { return (bits + 7) / 8; }
+};
+
+/**
+ * Minimal HID report descriptor parser. Handles the short items the space mouse descriptors use
+ * (global/local state, collections, input items) and records anything suspicious as a warning
+ * instead of failing, so the result can be used to check a descriptor for conformance.
+ */
+class HidDescriptor {
+    std::vector<HidReport> reports;
+    std::vector<std::string> warnings;
+
+    HidReport &reportFor(uint8_t id);
+    void warn(size_t pos, const std::string &msg);
+
+public:
+  bool parse(const uint8_t *data, size_t len);
+
+  const HidReport *find(uint8_t id) const;
+  const std::vector<HidReport> &allReports() const { return reports; }
+  const std::vector<std::string> &allWarnings() const { return warnings; }
+
+  // Human readable summary of all reports and fields.
+  std::string describe() const;
+};
+
+const char *hid_usage_name(uint16_t page, uint16_t usage);
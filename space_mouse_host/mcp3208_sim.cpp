@@ -0,0 +1,112 @@
+#include <math.h>
+#include "mcp3208_sim.h"
+
+// Below this the sample capacitor droops (datasheet minimum clock for the sample/hold).
+#define MCP3208_MIN_CLOCK_HZ 10000
+
+enum SimState {
+    WAIT_START,
+    CONFIG,  // SGL/DIFF, D2, D1, D0
+    SAMPLE,  // 1.5 clocks after D0, output still high impedance
+    NULL_BIT,
+    MSB_FIRST,
+    LSB_FIRST,
+    IDLE,
+};
+
+uint32_t Mcp3208Sim::maxClockHz(double vdd) {
+    if (vdd <= 2.7) {
+        return 1000000;
+    }
+    if (vdd >= 5.0) {
+        return 2000000;
+    }
+    return (uint32_t)(1000000 + (vdd - 2.7) / (5.0 - 2.7) * 1000000);
+}
+
+uint16_t Mcp3208Sim::expectedCode(int ch) const {
+    double code = floor(input[ch] / vref * 4096);
+    return code < 0 ? 0 : (code > 4095 ? 4095 : (uint16_t)code);
+}
+
+void Mcp3208Sim::transfer(const uint8_t *tx, uint8_t *rx, size_t len, uint32_t sclkHz) {
+    if (sclkHz > maxClockHz(vdd) || sclkHz < MCP3208_MIN_CLOCK_HZ) {
+        clockViolations++;
+    }
+    SimState state = WAIT_START;
+    int configBits = 0;
+    uint8_t config = 0;
+    uint16_t code = 0;
+    int bit = 0; // result bit being shifted out
+    for (size_t i = 0; i < len * 8; i++) {
+        int mosi = (tx[i / 8] >> (7 - i % 8)) & 1;
+        // MISO for this clock was set on the previous falling edge
+        int miso = 1;
+        switch (state) {
+            case NULL_BIT: miso = 0; break;
+            case MSB_FIRST: miso = (code >> bit) & 1; break;
+            case LSB_FIRST: miso = (code >> bit) & 1; break;
+            case IDLE: miso = 0; break;
+            default: break;
+        }
+        if (i % 8 == 0) {
+            rx[i / 8] = 0;
+        }
+        rx[i / 8] |= miso << (7 - i % 8);
+
+        // rising edge: chip samples MOSI, then the falling edge moves to the next output bit
+        switch (state) {
+            case WAIT_START:
+                if (mosi) {
+                    state = CONFIG;
+                }
+                break;
+            case CONFIG:
+                config = (config << 1) | mosi;
+                if (++configBits == 4) {
+                    int ch = config & 0x07;
+                    bool single = config & 0x08;
+                    if (!single) {
+                        // pseudo differential pairs CH0/CH1, CH2/CH3 ..., IN+ is the addressed channel
+                        int plus = ch, minus = ch ^ 1;
+                        double v = input[plus] - input[minus];
+                        double c = floor(v / vref * 4096);
+                        code = c < 0 ? 0 : (c > 4095 ? 4095 : (uint16_t)c);
+                    } else {
+                        code = expectedCode(ch);
+                    }
+                    state = SAMPLE;
+                }
+                break;
+            case SAMPLE:
+                state = NULL_BIT;
+                break;
+            case NULL_BIT:
+                state = MSB_FIRST;
+                bit = 11;
+                break;
+            case MSB_FIRST:
+                if (bit == 0) {
+                    conversions++;
+                    state = LSB_FIRST;
+                    bit = 1;
+                } else {
+                    bit--;
+                }
+                break;
+            case LSB_FIRST:
+                if (bit == 11) {
+                    state = IDLE;
+                } else {
+                    bit++;
+                }
+                break;
+            case IDLE:
+                break;
+        }
+    }
+    // CS goes high here
+    if (state != LSB_FIRST && state != IDLE) {
+        protocolErrors++;
+    }
+}
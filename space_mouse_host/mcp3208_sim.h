@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Bit level stand-in for the MCP3208. transfer() is one CS low period: MOSI is shifted in and
+ * MISO out MSB first (SPI mode 0) exactly as the chip does, including the high impedance bits
+ * before the null bit (read as 1) and the LSB first repeat of the result if the clock keeps
+ * running. Protocol and timing violations are counted instead of aborting.
+ */
+class Mcp3208Sim {
+public:
+  double vref = 3.3;
+  double vdd = 3.3;
+  double input[8] = {};
+
+  uint32_t conversions = 0;
+  uint32_t protocolErrors = 0;  // no start bit, or CS raised before the result was clocked out
+  uint32_t clockViolations = 0; // SCLK outside the range for vdd
+
+  void transfer(const uint8_t *tx, uint8_t *rx, size_t len, uint32_t sclkHz);
+
+  // Code the chip converts channel ch to with the current input.
+  uint16_t expectedCode(int ch) const;
+
+  // Datasheet SCLK limit, 1 MHz at 2.7 V to 2 MHz at 5 V.
+  static uint32_t maxClockHz(double vdd);
+};
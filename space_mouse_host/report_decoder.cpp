@@ -0,0 +1,110 @@
+#include <string.h>
+#include "report_decoder.h"
+
+const char *const SM_AXIS_NAMES[SM_AXES] = { "TX", "TY", "TZ", "RX", "RY", "RZ" };
+
+int sm_axis_index(uint16_t usagePage, uint16_t usage) {
+    if (usagePage != HID_PAGE_DESKTOP || usage < HID_DESKTOP_X || usage > HID_DESKTOP_RZ) {
+        return -1;
+    }
+    return usage - HID_DESKTOP_X;
+}
+
+// Little endian bit field starting at bit 'offset' of 'payload'.
+static uint32_t extractBits(const uint8_t *payload, uint32_t offset, uint32_t size) {
+    uint64_t v = 0;
+    uint32_t first = offset / 8;
+    uint32_t last = (offset + size - 1) / 8;
+    for (uint32_t b = first; b <= last; b++) {
+        v |= (uint64_t)payload[b] << (8 * (b - first));
+    }
+    v >>= offset % 8;
+    return size >= 32 ? (uint32_t)v : (uint32_t)(v & ((uint64_t(1) << size) - 1));
+}
+
+ReportDecoder::ReportDecoder(const HidDescriptor &descriptor) : desc(descriptor) {
+    for (int i = 0; i < 256; i++) {
+        byId[i] = desc.find(i);
+    }
+}
+
+size_t ReportDecoder::reportLength(uint8_t id) const {
+    const HidReport *r = byId[id];
+    return r ? r->byteLength() + 1 : 0;
+}
+
+uint32_t ReportDecoder::decode(const uint8_t *data, size_t len, SpaceMouseState &state) const {
+    state.axisMask = 0;
+    state.buttonsValid = false;
+    if (len == 0) {
+        return REPORT_ISSUE_EMPTY;
+    }
+    const HidReport *r = byId[data[0]];
+    if (!r) {
+        return REPORT_ISSUE_UNKNOWN_ID;
+    }
+    uint32_t issues = 0;
+    size_t payloadLen = len - 1;
+    if (payloadLen < r->byteLength()) {
+        issues |= REPORT_ISSUE_SHORT;
+    } else if (payloadLen > r->byteLength()) {
+        issues |= REPORT_ISSUE_LONG;
+    }
+    const uint8_t *payload = data + 1;
+    uint32_t availBits = payloadLen * 8;
+
+    for (const HidField &f : r->fields) {
+        if (f.isConstant || !f.sizeSupported()) {
+            continue; // unsupported sizes were rejected by parse(), never read them
+        }
+        for (uint32_t i = 0; i < f.reportCount; i++) {
+            uint32_t offset = f.bitOffset + i * f.reportSize;
+            if (offset + f.reportSize > availBits) {
+                break; // already flagged as short
+            }
+            uint32_t raw = extractBits(payload, offset, f.reportSize);
+            int32_t value = (int32_t)raw;
+            if (f.isSigned() && f.reportSize < 32 && (raw & (1u << (f.reportSize - 1)))) {
+                value = (int32_t)(raw | ~((1u << f.reportSize) - 1));
+            }
+            if (value < f.logicalMin || value > f.logicalMax) {
+                issues |= REPORT_ISSUE_OUT_OF_RANGE;
+            }
+            uint16_t usage = f.usage(i);
+            if (f.usagePage == HID_PAGE_BUTTON) {
+                if (usage >= 1 && usage <= 32) {
+                    uint32_t bit = 1u << (usage - 1);
+                    state.buttons = value ? (state.buttons | bit) : (state.buttons & ~bit);
+                    state.buttonsValid = true;
+                }
+                continue;
+            }
+            int ax = sm_axis_index(f.usagePage, usage);
+            if (ax >= 0) {
+                state.axis[ax] = value;
+                state.axisMask |= 1 << ax;
+            }
+        }
+    }
+    return issues;
+}
+
+std::string ReportDecoder::issueText(uint32_t issues) {
+    static const struct { uint32_t flag; const char *text; } names[] = {
+        { REPORT_ISSUE_UNKNOWN_ID, "unknown report id" },
+        { REPORT_ISSUE_SHORT, "short report" },
+        { REPORT_ISSUE_LONG, "long report" },
+        { REPORT_ISSUE_OUT_OF_RANGE, "value out of logical range" },
+        { REPORT_ISSUE_EMPTY, "empty report" },
+    };
+    std::string out;
+    for (auto &n : names) {
+        if (issues & n.flag) {
+            if (!out.empty()) {
+                out += ", ";
+            }
+            out += n.text;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "hid_descriptor.h"
+
+// Axis order used by all host tools, same as the trace stream: TX TY TZ RX RY RZ
+#define SM_AXES 6
+
+#define REPORT_ISSUE_UNKNOWN_ID   0x01 // report ID not declared in the descriptor
+#define REPORT_ISSUE_SHORT        0x02 // fewer bytes than the descriptor declares
+#define REPORT_ISSUE_LONG         0x04 // more bytes than the descriptor declares
+#define REPORT_ISSUE_OUT_OF_RANGE 0x08 // value outside the logical range
+#define REPORT_ISSUE_EMPTY        0x10 // zero length report
+
+/**
+ * Decoded device state. Reports 1/2 (or the single combined report) update the axes,
+ * report 3 updates the buttons. axisMask/buttonsValid tell which parts the last report touched.
+ */
+struct SpaceMouseState {
+    int32_t axis[SM_AXES];
+    uint32_t buttons;
+    uint8_t axisMask;
+    bool buttonsValid;
+};
+
+/**
+ * Decodes report bytes (report ID first, as delivered by hidraw) against a parsed descriptor.
+ * Lookup tables are built once in the constructor, decode() does not allocate.
+ */
+class ReportDecoder {
+    const HidDescriptor &desc;
+    const HidReport *byId[256];
+
+public:
+  explicit ReportDecoder(const HidDescriptor &descriptor);
+
+  // Length of the report including the ID byte, 0 if the ID is unknown.
+  size_t reportLength(uint8_t id) const;
+
+  // Decode one report into state. Returns a mask of REPORT_ISSUE_* flags, 0 if the report conforms.
+  uint32_t decode(const uint8_t *data, size_t len, SpaceMouseState &state) const;
+
+  static std::string issueText(uint32_t issues);
+};
+
+// Index into SpaceMouseState::axis for a generic desktop usage, -1 if not an axis.
+int sm_axis_index(uint16_t usagePage, uint16_t usage);
+
+extern const char *const SM_AXIS_NAMES[SM_AXES];
@@ -0,0 +1,28 @@
+#include <string.h>
+#include "sm_descriptors.h"
+
+#include "tusb_hid_items.h"
+#include "hid_report_desc.h"
+
+// Expanded from the firmware descriptor macros, see tusb_hid_items.h.
+const uint8_t SM_DESC_SPLIT[] = { TUD_HID_REPORT_DESC_SPACE_MOUSE_SPLIT };
+const size_t SM_DESC_SPLIT_LEN = sizeof(SM_DESC_SPLIT);
+
+const uint8_t SM_DESC_COMBINED[] = { TUD_HID_REPORT_DESC_SPACE_MOUSE_COMBINED };
+const size_t SM_DESC_COMBINED_LEN = sizeof(SM_DESC_COMBINED);
+
+static const SmVariant variants[] = {
+    { "split", SM_DESC_SPLIT, sizeof(SM_DESC_SPLIT) },
+    { "pro", SM_DESC_SPLIT, sizeof(SM_DESC_SPLIT) },
+    { "combined", SM_DESC_COMBINED, sizeof(SM_DESC_COMBINED) },
+    { "enterprise", SM_DESC_COMBINED, sizeof(SM_DESC_COMBINED) },
+};
+
+const SmVariant *sm_variant(const char *name) {
+    for (auto &v : variants) {
+        if (strcmp(v.name, name) == 0) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Byte images of the two TUD_HID_REPORT_DESC_SPACE_MOUSE variants, expanded from the firmware's
+// space_mouse_hid/main/hid_report_desc.h.
+
+// DEVICE_TYPE 66 (SpaceMouse Pro / Wireless): report 1 = X Y Z, report 2 = RX RY RZ, report 3 = 32 buttons
+extern const uint8_t SM_DESC_SPLIT[];
+extern const size_t SM_DESC_SPLIT_LEN;
+
+// DEVICE_TYPE 12 (SpaceMouse Enterprise): report 1 = X Y Z RX RY RZ, report 3 = 32 buttons
+extern const uint8_t SM_DESC_COMBINED[];
+extern const size_t SM_DESC_COMBINED_LEN;
+
+struct SmVariant {
+    const char *name;
+    const uint8_t *desc;
+    size_t len;
+};
+
+// Look up a variant by name ("split"/"pro" or "combined"/"enterprise"), nullptr if unknown.
+const SmVariant *sm_variant(const char *name);
@@ -0,0 +1,388 @@
+// smhid: check the space mouse HID report descriptor and decode report streams on the host.
+//
+//   smhid describe [--variant split|combined | --descriptor FILE]
+//   smhid decode   [--variant ... | --descriptor FILE] [--hex] STREAM
+//   smhid synth    [--variant ...] [--count N] > STREAM
+//   smhid bench    [--variant ... | --descriptor FILE] [--count N]
+//   smhid check
+//
+// STREAM is either concatenated binary reports as read from /dev/hidrawN (report ID first),
+// or with --hex one report per line as hex bytes. FILE is a raw report descriptor, for example
+// /sys/class/hidraw/hidrawN/device/report_descriptor.
+//
+// check encodes test frames with the firmware report structs (space_mouse_hid/main/hid_report.h)
+// for both DEVICE_TYPE layouts and verifies the bytes against the matching built-in descriptor,
+// and that descriptors with unsupported field sizes are rejected.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "hid_descriptor.h"
+#include "report_decoder.h"
+#include "sm_descriptors.h"
+#include "hid_report.h"
+
+struct Options {
+    const char *command = nullptr;
+    const char *variant = "combined";
+    const char *descriptorFile = nullptr;
+    const char *input = nullptr;
+    bool hex = false;
+    long count = 1000000;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: smhid describe|decode|synth|bench|check [--variant split|combined] [--descriptor FILE]\n"
+        "             [--hex] [--count N] [STREAM]\n");
+    exit(2);
+}
+
+static bool readFile(const char *path, std::vector<uint8_t> &out) {
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+    return true;
+}
+
+static bool loadDescriptor(const Options &opt, HidDescriptor &desc) {
+    std::vector<uint8_t> bytes;
+    if (opt.descriptorFile) {
+        if (!readFile(opt.descriptorFile, bytes)) {
+            return false;
+        }
+    } else {
+        const SmVariant *v = sm_variant(opt.variant);
+        if (!v) {
+            fprintf(stderr, "unknown variant '%s'\n", opt.variant);
+            return false;
+        }
+        bytes.assign(v->desc, v->desc + v->len);
+    }
+    bool ok = desc.parse(bytes.data(), bytes.size());
+    for (auto &w : desc.allWarnings()) {
+        fprintf(stderr, "descriptor: %s\n", w.c_str());
+    }
+    return ok;
+}
+
+// Build reports with the firmware encoder, layout picked from the descriptor's report IDs.
+template<int DeviceType>
+static void synthFrames(long count, std::vector<uint8_t> &out) {
+    for (long n = 0; n < count; n++) {
+        int32_t axis[SM_AXES];
+        for (int a = 0; a < SM_AXES; a++) {
+            axis[a] = (int32_t)(350 * sin(n * 0.01 + a));
+        }
+        SmReportLayout<DeviceType> report;
+        report.set(axis[0], axis[1], axis[2], axis[3], axis[4], axis[5]);
+        for (int r = 0; r < SmReportLayout<DeviceType>::REPORT_COUNT; r++) {
+            uint8_t id;
+            uint16_t len;
+            const uint8_t *payload = report.report(r, id, len);
+            out.push_back(id);
+            out.insert(out.end(), payload, payload + len);
+        }
+    }
+}
+
+static void synthReports(const HidDescriptor &desc, long count, std::vector<uint8_t> &out) {
+    if (desc.find(2)) {
+        synthFrames<66>(count, out);
+    } else {
+        synthFrames<12>(count, out);
+    }
+}
+
+static int cmdDescribe(const Options &opt) {
+    HidDescriptor desc;
+    bool ok = loadDescriptor(opt, desc);
+    fputs(desc.describe().c_str(), stdout);
+    return ok && desc.allWarnings().empty() ? 0 : 1;
+}
+
+static bool parseHexLine(const char *line, std::vector<uint8_t> &out) {
+    out.clear();
+    int hi = -1;
+    for (const char *p = line; *p; p++) {
+        int v;
+        if (*p >= '0' && *p <= '9') v = *p - '0';
+        else if (*p >= 'a' && *p <= 'f') v = *p - 'a' + 10;
+        else if (*p >= 'A' && *p <= 'F') v = *p - 'A' + 10;
+        else if (*p == ' ' || *p == '\t' || *p == ':' || *p == '\r' || *p == '\n') continue;
+        else return false;
+        if (hi < 0) {
+            hi = v;
+        } else {
+            out.push_back(hi << 4 | v);
+            hi = -1;
+        }
+    }
+    return hi < 0;
+}
+
+static int cmdDecode(const Options &opt) {
+    if (!opt.input) {
+        usage();
+    }
+    HidDescriptor desc;
+    if (!loadDescriptor(opt, desc)) {
+        return 1;
+    }
+    ReportDecoder decoder(desc);
+    SpaceMouseState state = {};
+    long index = 0, bad = 0;
+
+    auto emit = [&](const uint8_t *data, size_t len) {
+        uint32_t issues = decoder.decode(data, len, state);
+        printf("%ld,%u", index, len ? data[0] : 0);
+        for (int a = 0; a < SM_AXES; a++) {
+            printf(",%d", state.axis[a]);
+        }
+        printf(",0x%08x,%s\n", state.buttons, ReportDecoder::issueText(issues).c_str());
+        if (issues) {
+            bad++;
+        }
+        index++;
+    };
+
+    printf("index,id,TX,TY,TZ,RX,RY,RZ,buttons,issues\n");
+    if (opt.hex) {
+        FILE *f = strcmp(opt.input, "-") == 0 ? stdin : fopen(opt.input, "r");
+        if (!f) {
+            perror(opt.input);
+            return 1;
+        }
+        char line[1024];
+        std::vector<uint8_t> bytes;
+        while (fgets(line, sizeof(line), f)) {
+            if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+                continue;
+            }
+            if (!parseHexLine(line, bytes)) {
+                fprintf(stderr, "report %ld: not a hex line\n", index);
+                bad++;
+                continue;
+            }
+            emit(bytes.data(), bytes.size());
+        }
+        if (f != stdin) {
+            fclose(f);
+        }
+    } else {
+        std::vector<uint8_t> stream;
+        if (!readFile(opt.input, stream)) {
+            return 1;
+        }
+        size_t pos = 0;
+        while (pos < stream.size()) {
+            size_t len = decoder.reportLength(stream[pos]);
+            if (len == 0) {
+                // unknown ID, report it and resync on the next byte
+                emit(&stream[pos], 1);
+                pos++;
+                continue;
+            }
+            if (pos + len > stream.size()) {
+                len = stream.size() - pos;
+            }
+            emit(&stream[pos], len);
+            pos += len;
+        }
+    }
+    fprintf(stderr, "%ld reports, %ld not conforming to the descriptor\n", index, bad);
+    return bad ? 1 : 0;
+}
+
+static int cmdSynth(const Options &opt) {
+    HidDescriptor desc;
+    if (!loadDescriptor(opt, desc)) {
+        return 1;
+    }
+    std::vector<uint8_t> out;
+    synthReports(desc, opt.count, out);
+    fwrite(out.data(), 1, out.size(), stdout);
+    return 0;
+}
+
+// Encode frames with SmReportLayout<DeviceType> and decode them against the descriptor bytes.
+template<int DeviceType>
+static long checkLayout(const char *variant) {
+    const SmVariant *v = sm_variant(variant);
+    HidDescriptor desc;
+    long failures = 0;
+    if (!desc.parse(v->desc, v->len) || !desc.allWarnings().empty()) {
+        printf("%s: descriptor does not parse cleanly\n", variant);
+        return 1;
+    }
+    ReportDecoder decoder(desc);
+    static const int32_t values[] = { 0, 1, -1, 255, 256, -256, 1000, -1000, 32767, -32768, 32768, -32769,
+        70000, -70000 };
+    const int n = sizeof(values) / sizeof(values[0]);
+    long frames = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t in[SM_AXES];
+        for (int a = 0; a < SM_AXES; a++) {
+            in[a] = values[(i + a * 5) % n];
+        }
+        SmReportLayout<DeviceType> report;
+        report.set(in[0], in[1], in[2], in[3], in[4], in[5]);
+
+        SpaceMouseState state = {};
+        uint8_t seen = 0;
+        for (int r = 0; r < SmReportLayout<DeviceType>::REPORT_COUNT; r++) {
+            uint8_t id;
+            uint16_t len;
+            const uint8_t *payload = report.report(r, id, len);
+            uint8_t wire[64];
+            wire[0] = id; // as the host sees it, TinyUSB prepends the ID
+            memcpy(wire + 1, payload, len);
+            uint32_t issues = decoder.decode(wire, len + 1, state);
+            if (issues) {
+                printf("%s: report %u: %s\n", variant, id, ReportDecoder::issueText(issues).c_str());
+                failures++;
+            }
+            seen |= state.axisMask;
+        }
+        if (seen != (1 << SM_AXES) - 1) {
+            printf("%s: frame %d does not cover all axes (mask 0x%02x)\n", variant, i, seen);
+            failures++;
+        }
+        for (int a = 0; a < SM_AXES; a++) {
+            int32_t expected = in[a] > 32767 ? 32767 : (in[a] < -32768 ? -32768 : in[a]);
+            if (state.axis[a] != expected) {
+                printf("%s: frame %d %s: sent %d, decoded %d, expected %d\n", variant, i, SM_AXIS_NAMES[a], in[a],
+                    state.axis[a], expected);
+                failures++;
+            }
+        }
+        frames++;
+    }
+    printf("%s (DEVICE_TYPE %d): %ld frames, %ld failures\n", variant, DeviceType, frames, failures);
+    return failures;
+}
+
+// Descriptors with field sizes the decoder can not handle (0 and 33 bits): parse() must reject them,
+// and decoding against the result anyway must neither crash nor report values.
+static long checkBadFieldSizes() {
+    long failures = 0;
+    for (uint8_t size : { 0, 33 }) {
+        const uint8_t bytes[] = {
+            0x05, 0x01,       // Usage Page (Generic Desktop)
+            0x09, 0x08,       // Usage (Multi-Axis Controller)
+            0xa1, 0x01,       // Collection (Application)
+            0x85, 0x01,       //  Report ID (1)
+            0x15, 0x00,       //  Logical Minimum (0)
+            0x25, 0x01,       //  Logical Maximum (1)
+            0x75, size,       //  Report Size
+            0x95, 0x03,       //  Report Count (3)
+            0x09, 0x30,       //  Usage (X)
+            0x09, 0x31,       //  Usage (Y)
+            0x09, 0x32,       //  Usage (Z)
+            0x81, 0x02,       //  Input (Data, Variable, Absolute)
+            0xc0              // End Collection
+        };
+        HidDescriptor desc;
+        if (desc.parse(bytes, sizeof(bytes))) {
+            printf("report size %u: descriptor accepted\n", size);
+            failures++;
+        }
+        ReportDecoder decoder(desc);
+        const uint8_t wire[] = { 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+        SpaceMouseState state = {};
+        decoder.decode(wire, sizeof(wire), state);
+        if (state.axisMask) {
+            printf("report size %u: decoded axes (mask 0x%02x)\n", size, state.axisMask);
+            failures++;
+        }
+    }
+    printf("unsupported field sizes: %ld failures\n", failures);
+    return failures;
+}
+
+static int cmdCheck() {
+    long failures = checkLayout<66>("split") + checkLayout<12>("combined") + checkBadFieldSizes();
+    return failures ? 1 : 0;
+}
+
+static int cmdBench(const Options &opt) {
+    HidDescriptor desc;
+    if (!loadDescriptor(opt, desc)) {
+        return 1;
+    }
+    ReportDecoder decoder(desc);
+    std::vector<uint8_t> stream;
+    synthReports(desc, opt.count, stream);
+
+    SpaceMouseState state = {};
+    long reports = 0, bad = 0;
+    int64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        size_t len = decoder.reportLength(stream[pos]);
+        if (len == 0 || pos + len > stream.size()) {
+            break;
+        }
+        if (decoder.decode(&stream[pos], len, state)) {
+            bad++;
+        }
+        sum += state.axis[0];
+        pos += len;
+        reports++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("variant %s: %ld reports (%zu bytes) in %.3f ms\n", opt.descriptorFile ? opt.descriptorFile : opt.variant,
+        reports, stream.size(), elapsed * 1e3);
+    printf("%.1f Mreports/s, %.1f ns/report, %.1f MB/s (checksum %lld, %ld bad)\n",
+        reports / elapsed / 1e6, elapsed * 1e9 / (reports ? reports : 1), stream.size() / elapsed / 1e6,
+        (long long)sum, bad);
+    return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "--variant") == 0 && i + 1 < argc) {
+            opt.variant = argv[++i];
+        } else if (strcmp(a, "--descriptor") == 0 && i + 1 < argc) {
+            opt.descriptorFile = argv[++i];
+        } else if (strcmp(a, "--count") == 0 && i + 1 < argc) {
+            opt.count = atol(argv[++i]);
+        } else if (strcmp(a, "--hex") == 0) {
+            opt.hex = true;
+        } else if (a[0] == '-' && a[1] == '-') {
+            usage();
+        } else if (!opt.command) {
+            opt.command = a;
+        } else if (!opt.input) {
+            opt.input = a;
+        } else {
+            usage();
+        }
+    }
+    if (!opt.command) {
+        usage();
+    }
+    if (strcmp(opt.command, "describe") == 0) return cmdDescribe(opt);
+    if (strcmp(opt.command, "decode") == 0) return cmdDecode(opt);
+    if (strcmp(opt.command, "synth") == 0) return cmdSynth(opt);
+    if (strcmp(opt.command, "bench") == 0) return cmdBench(opt);
+    if (strcmp(opt.command, "check") == 0) return cmdCheck();
+    usage();
+    return 2;
+}
@@ -0,0 +1,190 @@
+// smnavbench: end to end latency of smnavd's server loop against the pipe stand-in device.
+//
+//   smnavbench [--variant split|combined] [--count N] [--socket PATH]
+//
+// The server runs in its own thread on the stand-in; a spacenavd protocol 0 client connects to the
+// socket. Each frame is written like the firmware sends it and timed until the client has read
+// the motion event (ping-pong, one frame in flight). The decoded values are checked against what
+// was sent, button press/release is checked at the end, and heap allocations made while frames
+// are flowing are counted: the loop must not allocate.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+#include "hid_descriptor.h"
+#include "report_decoder.h"
+#include "sm_descriptors.h"
+#include "spnav_server.h"
+#include "standin_device.h"
+
+static std::atomic<long> allocations{0};
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+// Read one event, false on timeout or error.
+static bool readEvent(int fd, int *ev, int timeoutMs) {
+    size_t got = 0;
+    const size_t len = SPNAV_EV_INTS * sizeof(int);
+    while (got < len) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, timeoutMs) <= 0) {
+            return false;
+        }
+        ssize_t n = read(fd, (char *)ev + got, len - got);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+static void frameAxes(long n, int32_t *axis) {
+    // consecutive frames always differ, so every frame is published
+    for (int a = 0; a < SM_AXES; a++) {
+        axis[a] = (int32_t)((n * 7 + a * 113) % 700) - 350;
+    }
+}
+
+template<int DeviceType>
+static int bench(const ReportDecoder &decoder, long count, const char *socketPath) {
+    StandInDevice<DeviceType> dev;
+    if (!dev.open()) {
+        perror("pipe2");
+        return 1;
+    }
+    NavServer nav(decoder);
+    if (!nav.open(dev.releaseReadFd(), socketPath)) {
+        return 1;
+    }
+    std::thread serverThread([&nav] { nav.run(); });
+
+    int client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    if (client < 0 || connect(client, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror(socketPath);
+        nav.stop();
+        serverThread.join();
+        return 1;
+    }
+
+    int ev[SPNAV_EV_INTS];
+    int32_t axis[SM_AXES];
+    // the server accepts asynchronously, send frames until the client sees one
+    long n = 0;
+    do {
+        frameAxes(n++, axis);
+        dev.sendAxes(axis);
+    } while (!readEvent(client, ev, 100) && n < 50);
+    while (readEvent(client, ev, 20)) {
+        // drain warm-up events
+    }
+
+    std::vector<uint64_t> latency;
+    latency.reserve(count);
+    long mismatches = 0, timeouts = 0;
+    long allocBefore = allocations.load();
+    for (long i = 0; i < count; i++, n++) {
+        frameAxes(n, axis);
+        uint64_t t0 = nav_now_ns();
+        dev.sendAxes(axis);
+        if (!readEvent(client, ev, 1000)) {
+            timeouts++;
+            break;
+        }
+        latency.push_back(nav_now_ns() - t0);
+        bool match = ev[0] == SPNAV_EV_MOTION;
+        for (int a = 0; a < SM_AXES; a++) {
+            match = match && ev[1 + a] == axis[a];
+        }
+        mismatches += !match;
+    }
+    long allocs = allocations.load() - allocBefore;
+
+    // button 0 and 5 down, then 5 up
+    int buttonErrors = 0;
+    dev.sendButtons(0x21);
+    for (int b : { 0, 5 }) {
+        buttonErrors += !(readEvent(client, ev, 1000) && ev[0] == SPNAV_EV_PRESS && ev[1] == b);
+    }
+    dev.sendButtons(0x01);
+    buttonErrors += !(readEvent(client, ev, 1000) && ev[0] == SPNAV_EV_RELEASE && ev[1] == 5);
+
+    nav.stop();
+    serverThread.join();
+    close(client);
+
+    if (latency.empty()) {
+        fprintf(stderr, "no events received\n");
+        return 1;
+    }
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&latency](double p) { return latency[(size_t)(p * (latency.size() - 1))] / 1e3; };
+    const NavStats &s = nav.stats;
+    printf("DEVICE_TYPE %d: %zu frames, %llu reports, %ld value mismatches, %ld timeouts, %d button errors\n",
+        DeviceType, latency.size(), (unsigned long long)s.reports, mismatches, timeouts, buttonErrors);
+    printf("report write to client read: p50 %.1f us, p99 %.1f us, max %.1f us\n", pct(0.5), pct(0.99), pct(1.0));
+    printf("server decode to publish: mean %.2f us, p99 < %.2f us, max %.2f us\n",
+        s.latencySumNs / 1e3 / (s.latencyCount ? s.latencyCount : 1), s.percentileNs(0.99) / 1e3,
+        s.latencyMaxNs / 1e3);
+    printf("heap allocations while frames were flowing: %ld\n", allocs);
+    return mismatches || timeouts || buttonErrors || allocs ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *variant = "split";
+    long count = 20000;
+    char socketPath[64];
+    snprintf(socketPath, sizeof(socketPath), "/tmp/smnavbench.%d.sock", (int)getpid());
+    const char *socketArg = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--variant") == 0 && i + 1 < argc) {
+            variant = argv[++i];
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketArg = argv[++i];
+        } else {
+            fprintf(stderr, "usage: smnavbench [--variant split|combined] [--count N] [--socket PATH]\n");
+            return 2;
+        }
+    }
+    const SmVariant *v = sm_variant(variant);
+    if (!v) {
+        fprintf(stderr, "unknown variant '%s'\n", variant);
+        return 2;
+    }
+    HidDescriptor desc;
+    if (!desc.parse(v->desc, v->len)) {
+        return 1;
+    }
+    ReportDecoder decoder(desc);
+    const char *path = socketArg ? socketArg : socketPath;
+    return desc.find(2) ? bench<66>(decoder, count, path) : bench<12>(decoder, count, path);
+}
@@ -0,0 +1,180 @@
+// smnavd: publish the space mouse to spacenavd clients (libspnav, FreeCAD, Blender, ...) straight from hidraw.
+//
+//   smnavd [--device /dev/hidrawN] [--socket PATH] [--variant split|combined | --descriptor FILE]
+//
+// Without --device the first hidraw node with a space mouse vendor/product ID (the ones the
+// firmware can present) is used. The report descriptor is read from the node itself; --variant or
+// --descriptor are only needed when the input is not a hidraw node. Stop with SIGINT/SIGTERM,
+// statistics are printed on exit. Do not run it next to spacenavd, both want the same socket.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+#include <vector>
+#include "hid_descriptor.h"
+#include "report_decoder.h"
+#include "sm_descriptors.h"
+#include "spnav_server.h"
+
+static const struct { uint32_t vendor, product; } SM_IDS[] = {
+    { 0x046d, 0xc62b }, // SPACE_MOUSE_PRO
+    { 0x256f, 0xc631 }, // SPACE_MOUSE_WIRELESS
+    { 0x256f, 0xc633 }, // SPACE_MOUSE_ENTERPRISE
+};
+
+static NavServer *server;
+
+static void onSignal(int) {
+    server->stop();
+}
+
+// First /dev/hidrawN whose HID_ID matches SM_IDS.
+static bool findDevice(char *path, size_t len) {
+    DIR *dir = opendir("/sys/class/hidraw");
+    if (!dir) {
+        return false;
+    }
+    bool found = false;
+    struct dirent *e;
+    while (!found && (e = readdir(dir))) {
+        if (strncmp(e->d_name, "hidraw", 6) != 0) {
+            continue;
+        }
+        char uevent[300];
+        snprintf(uevent, sizeof(uevent), "/sys/class/hidraw/%s/device/uevent", e->d_name);
+        FILE *f = fopen(uevent, "r");
+        if (!f) {
+            continue;
+        }
+        char line[256];
+        unsigned bus, vendor, product;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "HID_ID=%x:%x:%x", &bus, &vendor, &product) != 3) {
+                continue;
+            }
+            for (auto &id : SM_IDS) {
+                if (id.vendor == vendor && id.product == product) {
+                    snprintf(path, len, "/dev/%s", e->d_name);
+                    found = true;
+                }
+            }
+        }
+        fclose(f);
+    }
+    closedir(dir);
+    return found;
+}
+
+static bool readFile(const char *path, std::vector<uint8_t> &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *device = nullptr;
+    const char *socketPath = SPNAV_SOCKET_DEFAULT;
+    const char *variant = nullptr;
+    const char *descriptorFile = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            device = argv[++i];
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--variant") == 0 && i + 1 < argc) {
+            variant = argv[++i];
+        } else if (strcmp(argv[i], "--descriptor") == 0 && i + 1 < argc) {
+            descriptorFile = argv[++i];
+        } else {
+            fprintf(stderr, "usage: smnavd [--device /dev/hidrawN] [--socket PATH]"
+                " [--variant split|combined | --descriptor FILE]\n");
+            return 2;
+        }
+    }
+
+    char found[300];
+    if (!device) {
+        if (!findDevice(found, sizeof(found))) {
+            fprintf(stderr, "no space mouse hidraw node found, pass --device\n");
+            return 1;
+        }
+        device = found;
+    }
+    int fd = open(device, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(device);
+        return 1;
+    }
+
+    std::vector<uint8_t> bytes;
+    struct hidraw_report_descriptor rdesc = {};
+    int size = 0;
+    if (descriptorFile) {
+        if (!readFile(descriptorFile, bytes)) {
+            return 1;
+        }
+    } else if (variant) {
+        const SmVariant *v = sm_variant(variant);
+        if (!v) {
+            fprintf(stderr, "unknown variant '%s'\n", variant);
+            return 2;
+        }
+        bytes.assign(v->desc, v->desc + v->len);
+    } else if (ioctl(fd, HIDIOCGRDESCSIZE, &size) == 0) {
+        rdesc.size = size;
+        if (ioctl(fd, HIDIOCGRDESC, &rdesc) < 0) {
+            perror(device);
+            return 1;
+        }
+        bytes.assign(rdesc.value, rdesc.value + rdesc.size);
+    } else {
+        fprintf(stderr, "%s: not a hidraw node, pass --variant or --descriptor\n", device);
+        return 2;
+    }
+    HidDescriptor desc;
+    bool ok = desc.parse(bytes.data(), bytes.size());
+    for (auto &w : desc.allWarnings()) {
+        fprintf(stderr, "descriptor: %s\n", w.c_str());
+    }
+    if (!ok) {
+        return 1;
+    }
+    ReportDecoder decoder(desc);
+
+    NavServer nav(decoder);
+    if (!nav.open(fd, socketPath)) {
+        return 1;
+    }
+    server = &nav;
+    struct sigaction sa = {};
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    fprintf(stderr, "%s -> %s\n", device, socketPath);
+
+    ok = nav.run();
+
+    const NavStats &s = nav.stats;
+    fprintf(stderr, "%llu reports (%llu flagged), %llu motion and %llu button events, %llu dropped, %llu clients\n",
+        (unsigned long long)s.reports, (unsigned long long)s.badReports, (unsigned long long)s.motionEvents,
+        (unsigned long long)s.buttonEvents, (unsigned long long)s.droppedEvents, (unsigned long long)s.clientsAccepted);
+    if (s.latencyCount) {
+        fprintf(stderr, "decode to publish: mean %.1f us, p99 < %.1f us, max %.1f us\n",
+            s.latencySumNs / 1e3 / s.latencyCount, s.percentileNs(0.99) / 1e3, s.latencyMaxNs / 1e3);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+// smpredict: replay a recorded trace through the firmware latency predictor (predictor.h)
+// and report how much lag it removes and how much error it adds.
+//
+//   python ../space_mouse_hid/tools/trace2csv.py /dev/ttyACM0 > trace.csv
+//   smpredict [--lead-us N] trace.csv
+//   smpredict [--lead-us N] --synth       (synthetic orbit/pause motion, 200 Hz)
+//
+// For every frame the mixed TX..RZ values are extrapolated by lead-us. The ground truth is the
+// trace itself, interpolated at sample time + lead. "hold" is the unpredicted value the firmware
+// would send otherwise. Effective lag is the shift of the true signal that best matches the output.
+// Exits 1 if the prediction does not reduce both the effective lag and the error at transmit time.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "predictor.h"
+
+#define AXES 6
+static const char *const AXIS_NAMES[AXES] = { "TX", "TY", "TZ", "RX", "RY", "RZ" };
+
+struct Sample {
+    int64_t us;
+    int16_t axis[AXES];
+};
+
+static bool loadCsv(const char *path, std::vector<Sample> &out) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[4096];
+    int colTs = -1, colAxis[AXES];
+    for (int a = 0; a < AXES; a++) {
+        colAxis[a] = -1;
+    }
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return false;
+    }
+    int col = 0;
+    for (char *tok = strtok(line, ",\r\n"); tok; tok = strtok(nullptr, ",\r\n"), col++) {
+        if (strcmp(tok, "timestamp_us") == 0) {
+            colTs = col;
+        }
+        for (int a = 0; a < AXES; a++) {
+            if (strcmp(tok, AXIS_NAMES[a]) == 0) {
+                colAxis[a] = col;
+            }
+        }
+    }
+    if (colTs < 0) {
+        fprintf(stderr, "%s: no timestamp_us column\n", path);
+        fclose(f);
+        return false;
+    }
+    for (int a = 0; a < AXES; a++) {
+        if (colAxis[a] < 0) {
+            fprintf(stderr, "%s: no %s column\n", path, AXIS_NAMES[a]);
+            fclose(f);
+            return false;
+        }
+    }
+    // timestamps are the low 32 bits of esp_timer, unwrap them
+    int64_t base = 0;
+    uint32_t lastTs = 0;
+    while (fgets(line, sizeof(line), f)) {
+        Sample s = {};
+        uint32_t ts = 0;
+        col = 0;
+        for (char *tok = strtok(line, ",\r\n"); tok; tok = strtok(nullptr, ",\r\n"), col++) {
+            if (col == colTs) {
+                ts = strtoul(tok, nullptr, 10);
+            }
+            for (int a = 0; a < AXES; a++) {
+                if (col == colAxis[a]) {
+                    s.axis[a] = atoi(tok);
+                }
+            }
+        }
+        if (!out.empty() && ts < lastTs) {
+            base += int64_t(1) << 32;
+        }
+        lastTs = ts;
+        s.us = base + ts;
+        out.push_back(s);
+    }
+    fclose(f);
+    return true;
+}
+
+// Smooth pushes separated by pauses at rest, like orbiting a model, plus ADC noise.
+static void synthTrace(std::vector<Sample> &out) {
+    srand(1);
+    const int periodUs = 5000;
+    for (int n = 0; n < 20000; n++) {
+        Sample s;
+        s.us = (int64_t)n * periodUs + rand() % 300;
+        double t = s.us / 1e6;
+        for (int a = 0; a < AXES; a++) {
+            double phase = t * (0.3 + 0.07 * a) + a;
+            double env = sin(phase);
+            double v = env > 0.2 ? 500 * (env - 0.2) * sin(t * (4.0 + 0.5 * a)) : 0;
+            v += (rand() % 5) - 2;
+            s.axis[a] = fabs(v) < 5 ? 0 : (int16_t)lrint(v);
+        }
+        out.push_back(s);
+    }
+}
+
+// Trace value of an axis at time us, linear between samples. Returns false outside the trace.
+static bool truthAt(const std::vector<Sample> &tr, size_t &hint, int64_t us, int axis, double &value) {
+    if (us < tr.front().us || us > tr.back().us) {
+        return false;
+    }
+    while (hint > 0 && tr[hint].us > us) {
+        hint--;
+    }
+    while (hint + 1 < tr.size() && tr[hint + 1].us < us) {
+        hint++;
+    }
+    const Sample &a = tr[hint];
+    const Sample &b = tr[hint + 1 < tr.size() ? hint + 1 : hint];
+    if (b.us == a.us) {
+        value = a.axis[axis];
+        return true;
+    }
+    double f = (double)(us - a.us) / (b.us - a.us);
+    value = a.axis[axis] + f * (b.axis[axis] - a.axis[axis]);
+    return true;
+}
+
+// RMS of output[i] against the true signal at sample time + lead - lag, over moving samples only.
+static double rmsError(const std::vector<Sample> &tr, const std::vector<Sample> &output, int64_t leadUs,
+    int64_t lagUs, int axis) {
+    double sum = 0;
+    long n = 0;
+    size_t hint = 0;
+    for (size_t i = 0; i < tr.size(); i++) {
+        double truth;
+        if (!truthAt(tr, hint, tr[i].us + leadUs - lagUs, axis, truth)) {
+            continue;
+        }
+        if (truth == 0 && output[i].axis[axis] == 0) {
+            continue; // at rest, says nothing about lag
+        }
+        double e = output[i].axis[axis] - truth;
+        sum += e * e;
+        n++;
+    }
+    return n ? sqrt(sum / n) : 0;
+}
+
+static int64_t effectiveLag(const std::vector<Sample> &tr, const std::vector<Sample> &output, int64_t leadUs,
+    double &rmsAtLag) {
+    int64_t best = 0;
+    rmsAtLag = INFINITY;
+    for (int64_t lag = -leadUs; lag <= 2 * leadUs; lag += 250) {
+        double total = 0;
+        for (int a = 0; a < AXES; a++) {
+            double e = rmsError(tr, output, leadUs, lag, a);
+            total += e * e;
+        }
+        total = sqrt(total / AXES);
+        if (total < rmsAtLag) {
+            rmsAtLag = total;
+            best = lag;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    int64_t leadUs = 5500;
+    const char *input = nullptr;
+    bool synth = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--lead-us") == 0 && i + 1 < argc) {
+            leadUs = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--synth") == 0) {
+            synth = true;
+        } else if (argv[i][0] != '-' && !input) {
+            input = argv[i];
+        } else {
+            fprintf(stderr, "usage: smpredict [--lead-us N] (trace.csv | --synth)\n");
+            return 2;
+        }
+    }
+    std::vector<Sample> trace;
+    if (synth) {
+        synthTrace(trace);
+    } else if (!input || !loadCsv(input, trace)) {
+        fprintf(stderr, "usage: smpredict [--lead-us N] (trace.csv | --synth)\n");
+        return 2;
+    }
+    if (trace.size() < 3) {
+        fprintf(stderr, "trace too short\n");
+        return 1;
+    }
+
+    std::vector<Sample> predicted = trace;
+    Predictor predictor;
+    long active = 0;
+    for (size_t i = 0; i < predicted.size(); i++) {
+        predictor.apply(predicted[i].axis, trace[i].us, trace[i].us + leadUs);
+        if (memcmp(predicted[i].axis, trace[i].axis, sizeof(trace[i].axis)) != 0) {
+            active++;
+        }
+    }
+
+    printf("%zu frames, lead %lld us, prediction changed %ld frames (%.1f%%)\n", trace.size(),
+        (long long)leadUs, active, 100.0 * active / trace.size());
+    printf("axis  rms hold  rms pred  (error against truth at transmit time)\n");
+    double sumHold = 0, sumPred = 0;
+    for (int a = 0; a < AXES; a++) {
+        double hold = rmsError(trace, trace, leadUs, 0, a);
+        double pred = rmsError(trace, predicted, leadUs, 0, a);
+        printf("%-4s  %8.2f  %8.2f\n", AXIS_NAMES[a], hold, pred);
+        sumHold += hold * hold;
+        sumPred += pred * pred;
+    }
+    double rmsHold, rmsPred;
+    int64_t lagHold = effectiveLag(trace, trace, leadUs, rmsHold);
+    int64_t lagPred = effectiveLag(trace, predicted, leadUs, rmsPred);
+    printf("effective lag hold %.2f ms, predicted %.2f ms, removed %.2f ms\n", lagHold / 1e3, lagPred / 1e3,
+        (lagHold - lagPred) / 1e3);
+    printf("residual rms at best lag: hold %.2f, predicted %.2f\n", rmsHold, rmsPred);
+    // the predictor has to earn its place: less lag and less error at transmit time than holding
+    bool helps = lagPred < lagHold && sumPred < sumHold;
+    printf("prediction %s: rms at transmit time hold %.2f, predicted %.2f\n", helps ? "helps" : "DOES NOT HELP",
+        sqrt(sumHold / AXES), sqrt(sumPred / AXES));
+    return helps ? 0 : 1;
+}
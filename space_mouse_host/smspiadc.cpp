@@ -0,0 +1,142 @@
+// smspiadc: run the firmware MCP3208 frame code (space_mouse_hid/main/mcp3208.h) against the
+// bit level chip stand-in and report correctness and frame timing.
+//
+//   smspiadc [--frames N] [--sclk HZ] [--vdd V] [--trans-overhead-us US] [--samples N] [--script FILE]
+//
+// FILE is a CSV of "t_ms,v0,...,v7" rows, channel voltages are linearly interpolated between rows.
+// Without a script every channel moves on its own slow sine around mid scale.
+// Frame time is modelled as 8 transfers of 24 clocks plus a per-transfer gap, which is the larger of
+// the chip's minimum CS high time and the driver's per-transfer overhead (queue + ISR, an estimate).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "mcp3208.h"
+#include "mcp3208_sim.h"
+
+#define MCP3208_TCSH_US 0.5 // minimum CS disable time
+
+struct ScriptRow {
+    double ms;
+    double v[MCP3208_CHANNELS];
+};
+
+static bool loadScript(const char *path, std::vector<ScriptRow> &rows) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        ScriptRow r;
+        char *p = line;
+        char *end;
+        r.ms = strtod(p, &end);
+        if (end == p) {
+            continue; // header or comment
+        }
+        for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+            p = end + (*end == ',');
+            r.v[ch] = strtod(p, &end);
+        }
+        rows.push_back(r);
+    }
+    fclose(f);
+    return !rows.empty();
+}
+
+static void inputAt(const std::vector<ScriptRow> &script, double ms, double vref, double *v) {
+    if (script.empty()) {
+        for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+            v[ch] = vref / 2 + vref * 0.45 * sin(ms / 1000.0 * (0.7 + 0.3 * ch) + ch);
+        }
+        return;
+    }
+    size_t i = 0;
+    while (i + 1 < script.size() && script[i + 1].ms <= ms) {
+        i++;
+    }
+    const ScriptRow &a = script[i];
+    const ScriptRow &b = script[i + 1 < script.size() ? i + 1 : i];
+    double f = b.ms > a.ms ? (ms - a.ms) / (b.ms - a.ms) : 0;
+    if (f < 0) f = 0;
+    if (f > 1) f = 1;
+    for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+        v[ch] = a.v[ch] + f * (b.v[ch] - a.v[ch]);
+    }
+}
+
+int main(int argc, char **argv) {
+    long frames = 10000;
+    uint32_t sclk = 1000000;
+    double overheadUs = 12;
+    int samples = 5;
+    const char *scriptPath = nullptr;
+    Mcp3208Sim chip;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--sclk") == 0 && i + 1 < argc) {
+            sclk = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--vdd") == 0 && i + 1 < argc) {
+            chip.vdd = atof(argv[++i]);
+            chip.vref = chip.vdd;
+        } else if (strcmp(argv[i], "--trans-overhead-us") == 0 && i + 1 < argc) {
+            overheadUs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            scriptPath = argv[++i];
+        } else {
+            fprintf(stderr, "usage: smspiadc [--frames N] [--sclk HZ] [--vdd V] [--trans-overhead-us US]"
+                " [--samples N] [--script FILE]\n");
+            return 2;
+        }
+    }
+    std::vector<ScriptRow> script;
+    if (scriptPath && !loadScript(scriptPath, script)) {
+        fprintf(stderr, "%s: no rows\n", scriptPath);
+        return 2;
+    }
+
+    double xferUs = MCP3208_XFER_BYTES * 8 * 1e6 / sclk;
+    double gapUs = overheadUs > MCP3208_TCSH_US ? overheadUs : MCP3208_TCSH_US;
+    double frameUs = MCP3208_CHANNELS * (xferUs + gapUs);
+
+    // same buffers and decode as the firmware, the chip takes the place of the SPI DMA
+    Mcp3208Frame frame;
+    frame.init();
+    long mismatches = 0;
+    double ms = 0;
+    for (long n = 0; n < frames; n++) {
+        int values[MCP3208_CHANNELS];
+        uint16_t expected[MCP3208_CHANNELS];
+        for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+            // each channel is sampled at its own point within the frame
+            inputAt(script, ms + ch * (xferUs + gapUs) / 1000.0, chip.vref, chip.input);
+            expected[ch] = chip.expectedCode(ch);
+            chip.transfer(frame.tx[ch], frame.rx[ch], MCP3208_XFER_BYTES, sclk);
+        }
+        frame.decode(values);
+        for (int ch = 0; ch < MCP3208_CHANNELS; ch++) {
+            if (values[ch] != expected[ch]) {
+                if (mismatches < 10) {
+                    printf("frame %ld CH%d: decoded %d, chip converted %u\n", n, ch, values[ch], expected[ch]);
+                }
+                mismatches++;
+            }
+        }
+        ms += frameUs / 1000.0;
+    }
+
+    printf("%ld frames, %u conversions, %ld mismatches, %u protocol errors, %u clock violations (max %u Hz at %.1f V)\n",
+        frames, chip.conversions, mismatches, chip.protocolErrors, chip.clockViolations,
+        Mcp3208Sim::maxClockHz(chip.vdd), chip.vdd);
+    printf("SCLK %u Hz: %.1f us per transfer + %.1f us gap, frame %.1f us, %.0f frames/s\n", sclk, xferUs, gapUs,
+        frameUs, 1e6 / frameUs);
+    printf("%d frames averaged per report: %.2f ms sampling per report, %.0f reports/s max\n", samples,
+        samples * frameUs / 1000.0, 1e6 / (samples * frameUs));
+    return mismatches || chip.protocolErrors || chip.clockViolations ? 1 : 0;
+}
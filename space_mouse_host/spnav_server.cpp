@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "spnav_server.h"
+
+#define ALL_AXES ((1 << SM_AXES) - 1)
+
+uint64_t nav_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+uint64_t NavStats::percentileNs(double p) const {
+    uint64_t total = 0;
+    for (int b = 0; b < NAV_LATENCY_BUCKETS; b++) {
+        total += latencyHist[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * total);
+    uint64_t seen = 0;
+    for (int b = 0; b < NAV_LATENCY_BUCKETS; b++) {
+        seen += latencyHist[b];
+        if (seen > rank) {
+            return (uint64_t)1 << (b + 1);
+        }
+    }
+    return (uint64_t)1 << NAV_LATENCY_BUCKETS;
+}
+
+NavServer::NavServer(const ReportDecoder &decoder) : decoder(decoder) {
+    inputFd = listenFd = epollFd = wakeFd = -1;
+    for (int i = 0; i < NAV_MAX_CLIENTS; i++) {
+        clients[i] = -1;
+    }
+    socketPath[0] = 0;
+    memset(&state, 0, sizeof(state));
+    pendingMask = 0;
+    memset(published, 0, sizeof(published));
+    publishedButtons = 0;
+    anyPublished = false;
+    lastMotionNs = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+NavServer::~NavServer() {
+    for (int i = 0; i < NAV_MAX_CLIENTS; i++) {
+        if (clients[i] >= 0) {
+            close(clients[i]);
+        }
+    }
+    for (int fd : { inputFd, listenFd, epollFd, wakeFd }) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (socketPath[0]) {
+        unlink(socketPath);
+    }
+}
+
+static bool watch(int epollFd, int fd) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool NavServer::open(int input, const char *path) {
+    inputFd = input;
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (epollFd < 0 || wakeFd < 0 || listenFd < 0) {
+        perror("smnavd");
+        return false;
+    }
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, NAV_MAX_CLIENTS) < 0) {
+        perror(path);
+        return false;
+    }
+    strcpy(socketPath, path);
+    chmod(path, 0666); // like spacenavd, any local user may read the device
+    if (!watch(epollFd, inputFd) || !watch(epollFd, listenFd) || !watch(epollFd, wakeFd)) {
+        perror("epoll_ctl");
+        return false;
+    }
+    return true;
+}
+
+void NavServer::stop() {
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0) {
+        // counter overflow only, run() is woken anyway
+    }
+}
+
+void NavServer::acceptClients() {
+    while (1) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0) {
+            return;
+        }
+        int slot = 0;
+        while (slot < NAV_MAX_CLIENTS && clients[slot] >= 0) {
+            slot++;
+        }
+        if (slot == NAV_MAX_CLIENTS || !watch(epollFd, fd)) {
+            close(fd);
+            continue;
+        }
+        clients[slot] = fd;
+        stats.clientsAccepted++;
+    }
+}
+
+void NavServer::closeClient(int slot) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, clients[slot], NULL);
+    close(clients[slot]);
+    clients[slot] = -1;
+}
+
+// Protocol 0 clients never send anything we act on, newer ones negotiate first and fall back
+// when nothing answers. Drain and detect hangups.
+void NavServer::handleClient(int slot) {
+    char scratch[256];
+    ssize_t n = read(clients[slot], scratch, sizeof(scratch));
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        closeClient(slot);
+    }
+}
+
+void NavServer::broadcast(const int *ev) {
+    const size_t len = SPNAV_EV_INTS * sizeof(int);
+    for (int i = 0; i < NAV_MAX_CLIENTS; i++) {
+        if (clients[i] < 0) {
+            continue;
+        }
+        ssize_t n = send(clients[i], ev, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n == (ssize_t)len) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            stats.droppedEvents++; // client not reading, never block the device for it
+        } else {
+            closeClient(i); // gone, or a partial write broke its event framing
+        }
+    }
+}
+
+bool NavServer::publishMotion(const int32_t *axis, uint64_t nowNs) {
+    pendingMask = 0;
+    if (anyPublished && memcmp(axis, published, sizeof(published)) == 0) {
+        return false;
+    }
+    int ev[SPNAV_EV_INTS];
+    ev[0] = SPNAV_EV_MOTION;
+    for (int a = 0; a < SM_AXES; a++) {
+        ev[1 + a] = axis[a];
+    }
+    uint64_t periodMs = lastMotionNs ? (nowNs - lastMotionNs) / 1000000 : 0;
+    ev[7] = periodMs > 1000 ? 1000 : (int)periodMs;
+    broadcast(ev);
+    memcpy(published, axis, sizeof(published));
+    anyPublished = true;
+    lastMotionNs = nowNs;
+    stats.motionEvents++;
+    return true;
+}
+
+bool NavServer::handleInput() {
+    uint8_t buf[64];
+    ssize_t n = read(inputFd, buf, sizeof(buf));
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR) {
+            return true;
+        }
+        perror("input");
+        return false;
+    }
+    if (n == 0) {
+        fprintf(stderr, "input closed\n");
+        return false;
+    }
+    uint64_t start = nav_now_ns();
+    int32_t before[SM_AXES];
+    memcpy(before, state.axis, sizeof(before));
+    uint32_t issues = decoder.decode(buf, n, state);
+    stats.reports++;
+    if (issues) {
+        stats.badReports++;
+    }
+    bool published = false;
+    if (state.axisMask) {
+        // the other half of a split frame went missing, publish what the last frame had
+        if (pendingMask & state.axisMask) {
+            published |= publishMotion(before, start);
+        }
+        pendingMask |= state.axisMask;
+        if (pendingMask == ALL_AXES) {
+            published |= publishMotion(state.axis, start);
+        }
+    }
+    if (state.buttonsValid && state.buttons != publishedButtons) {
+        uint32_t changed = state.buttons ^ publishedButtons;
+        for (int b = 0; b < 32; b++) {
+            if (changed & (1u << b)) {
+                int ev[SPNAV_EV_INTS] = {};
+                ev[0] = (state.buttons & (1u << b)) ? SPNAV_EV_PRESS : SPNAV_EV_RELEASE;
+                ev[1] = b;
+                broadcast(ev);
+                stats.buttonEvents++;
+            }
+        }
+        publishedButtons = state.buttons;
+        published = true;
+    }
+    if (published) {
+        uint64_t ns = nav_now_ns() - start;
+        int b = 0;
+        while (b + 1 < NAV_LATENCY_BUCKETS && (ns >> (b + 1))) {
+            b++;
+        }
+        stats.latencyHist[b]++;
+        stats.latencyCount++;
+        stats.latencySumNs += ns;
+        if (ns > stats.latencyMaxNs) {
+            stats.latencyMaxNs = ns;
+        }
+    }
+    return true;
+}
+
+bool NavServer::run() {
+    struct epoll_event events[NAV_MAX_CLIENTS + 3];
+    while (1) {
+        int n = epoll_wait(epollFd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                uint64_t v;
+                if (read(wakeFd, &v, sizeof(v)) < 0) {
+                    // already drained
+                }
+                return true;
+            } else if (fd == inputFd) {
+                if (!handleInput()) {
+                    return false;
+                }
+            } else if (fd == listenFd) {
+                acceptClients();
+            } else {
+                for (int c = 0; c < NAV_MAX_CLIENTS; c++) {
+                    if (clients[c] == fd) {
+                        handleClient(c);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
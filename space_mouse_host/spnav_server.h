@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "report_decoder.h"
+
+// spacenavd wire protocol 0, what libspnav falls back to without negotiation: every event is
+// SPNAV_EV_INTS native ints, the first one is the event type.
+#define SPNAV_EV_MOTION  0 // x y z rx ry rz period_ms
+#define SPNAV_EV_PRESS   1 // button number (0 based)
+#define SPNAV_EV_RELEASE 2 // button number (0 based)
+#define SPNAV_EV_INTS    8
+#define SPNAV_SOCKET_DEFAULT "/var/run/spnav.sock"
+
+#define NAV_MAX_CLIENTS 16
+#define NAV_LATENCY_BUCKETS 40 // bucket b holds latencies in [2^b, 2^(b+1)) ns
+
+struct NavStats {
+    uint64_t reports;
+    uint64_t badReports;     // reports the decoder flagged (still used unless the ID is unknown)
+    uint64_t motionEvents;
+    uint64_t buttonEvents;
+    uint64_t droppedEvents;  // not written because a client's socket buffer was full
+    uint64_t clientsAccepted;
+    uint64_t latencyCount;   // reports that published at least one event
+    uint64_t latencySumNs;   // report read to last client write
+    uint64_t latencyMaxNs;
+    uint64_t latencyHist[NAV_LATENCY_BUCKETS];
+
+    // Upper bound of the bucket holding the p-th quantile (0..1), 0 if nothing was measured.
+    uint64_t percentileNs(double p) const;
+};
+
+/**
+ * Reads reports from a hidraw node (or any fd that returns one report per read, see smnavbench)
+ * and publishes them as spacenavd events on a Unix socket. Split layouts are published once both
+ * halves of a frame arrived, unchanged frames are not published again.
+ * Everything the event loop touches is allocated in open(), run() does not allocate.
+ */
+class NavServer {
+    const ReportDecoder &decoder;
+    int inputFd;
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    int clients[NAV_MAX_CLIENTS];
+    char socketPath[108];
+    SpaceMouseState state;
+    uint8_t pendingMask;             // axes updated since the last motion event
+    int32_t published[SM_AXES];
+    uint32_t publishedButtons;
+    bool anyPublished;
+    uint64_t lastMotionNs;
+
+    void acceptClients();
+    void closeClient(int slot);
+    void handleClient(int slot);
+    bool handleInput();
+    bool publishMotion(const int32_t *axis, uint64_t nowNs);
+    void broadcast(const int *ev);
+
+public:
+  NavStats stats;
+
+  explicit NavServer(const ReportDecoder &decoder);
+  ~NavServer();
+
+  // Take ownership of inputFd and listen on socketPath (a stale socket file is replaced).
+  // Prints the reason and returns false on failure.
+  bool open(int inputFd, const char *socketPath);
+
+  // Serve until stop(). Returns false if the input failed or was closed.
+  bool run();
+
+  // Make run() return. Async signal safe, may be called from any thread.
+  void stop();
+};
+
+uint64_t nav_now_ns();
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "hid_report.h"
+
+/**
+ * Stand-in for the hidraw node of the device: a packet mode pipe (O_DIRECT), so every read
+ * returns exactly one report like hidraw does. Reports are encoded with the firmware structs
+ * from space_mouse_hid/main/hid_report.h, DeviceType selects the layout as in the firmware.
+ */
+template<int DeviceType>
+class StandInDevice {
+    int fds[2] = { -1, -1 };
+
+public:
+  ~StandInDevice() {
+      close();
+  }
+
+  bool open() {
+      return pipe2(fds, O_DIRECT | O_CLOEXEC) == 0;
+  }
+
+  // End the daemon reads from, hand it over to NavServer::open() (which then owns it).
+  int releaseReadFd() {
+      int fd = fds[0];
+      fds[0] = -1;
+      return fd;
+  }
+
+  // Write one frame as the firmware sends it, one or two reports.
+  bool sendAxes(const int32_t *axis) {
+      SmReportLayout<DeviceType> report;
+      report.set(axis[0], axis[1], axis[2], axis[3], axis[4], axis[5]);
+      for (int r = 0; r < SmReportLayout<DeviceType>::REPORT_COUNT; r++) {
+          uint8_t id;
+          uint16_t len;
+          const uint8_t *payload = report.report(r, id, len);
+          uint8_t buf[1 + sizeof(report)];
+          buf[0] = id;
+          memcpy(buf + 1, payload, len);
+          if (write(fds[1], buf, 1 + len) != 1 + len) {
+              return false;
+          }
+      }
+      return true;
+  }
+
+  // Report 3, 32 buttons as a little endian bitmap.
+  bool sendButtons(uint32_t buttons) {
+      uint8_t buf[5] = { 3, (uint8_t)buttons, (uint8_t)(buttons >> 8), (uint8_t)(buttons >> 16),
+          (uint8_t)(buttons >> 24) };
+      return write(fds[1], buf, sizeof(buf)) == sizeof(buf);
+  }
+
+  void close() {
+      for (int &fd : fds) {
+          if (fd >= 0) {
+              ::close(fd);
+              fd = -1;
+          }
+      }
+  }
+};